@@ -1,4 +1,8 @@
 #pragma once
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <set>
 #include <vector>
 #include <cassert>
@@ -31,14 +35,103 @@ namespace robin_hood
 namespace ecs
 {
     class World;
+    struct Table;
+
+    /* Bitset over dense component indices. Words are combined with plain loops so that matching
+     * a query against an archetype vectorises. */
+    struct ComponentSignature
+    {
+        static constexpr uint32_t wordBits = 64;
+
+        std::vector<uint64_t> words{};
+
+        void set(uint32_t bit)
+        {
+            if (bit / wordBits >= words.size()) {
+                words.resize(bit / wordBits + 1, 0);
+            }
+            words[bit / wordBits] |= uint64_t(1) << (bit % wordBits);
+        }
+
+        [[nodiscard]] bool test(uint32_t bit) const
+        {
+            return bit / wordBits < words.size() && (words[bit / wordBits] >> (bit % wordBits)) & 1;
+        }
+
+        /* True if every bit of other is set here */
+        [[nodiscard]] bool containsAll(const ComponentSignature & other) const
+        {
+            const size_t n = std::min(words.size(), other.words.size());
+            uint64_t missing = 0;
+            for (size_t i = 0; i < n; i++) {
+                missing |= other.words[i] & ~words[i];
+            }
+            for (size_t i = n; i < other.words.size(); i++) {
+                missing |= other.words[i];
+            }
+            return missing == 0;
+        }
+
+        [[nodiscard]] bool intersects(const ComponentSignature & other) const
+        {
+            const size_t n = std::min(words.size(), other.words.size());
+            uint64_t common = 0;
+            for (size_t i = 0; i < n; i++) {
+                common |= other.words[i] & words[i];
+            }
+            return common != 0;
+        }
+    };
+
+    inline constexpr archetype_id_t noArchetype = std::numeric_limits<archetype_id_t>::max();
+
+    /* Column slots touched when a row moves between the tables of two archetypes, see
+     * Table::planMove. Tags have no column and never appear. Plans are dropped along with the
+     * edges whenever tables are destroyed, so the table pointers stay valid. */
+    struct TransitionPlan
+    {
+        Table * fromTable = nullptr;
+        Table * toTable = nullptr;
+        std::vector<std::pair<uint16_t, uint16_t>> preserve{};
+        std::vector<uint16_t> add{};
+        std::vector<uint16_t> remove{};
+    };
+
+    /* Where adding or removing one component leads from an archetype. The plans are built by the
+     * world on first use of the edge. */
+    struct ArchetypeEdge
+    {
+        archetype_id_t add = noArchetype;
+        archetype_id_t remove = noArchetype;
+        std::unique_ptr<TransitionPlan> addPlan{};
+        std::unique_ptr<TransitionPlan> removePlan{};
+    };
 
     struct Archetype
     {
         std::set<component_id_t> components;
+        ComponentSignature signature;
         Hash hash_value;
-        uint16_t id;
+        archetype_id_t id;
+        /* Next archetype interned under the same hash, see ArchetypeManager::findOrCreateArchetype */
+        archetype_id_t nextWithHash = noArchetype;
         //World* world;
 
+        /* Node map so lastEdge stays valid as edges are added */
+        robin_hood::unordered_node_map<component_id_t, ArchetypeEdge> edges{};
+        component_id_t lastEdgeComponent = 0;
+        ArchetypeEdge * lastEdge = nullptr;
+
+        /* Plans for moves that add several components at once, keyed by destination */
+        robin_hood::unordered_flat_map<archetype_id_t, std::unique_ptr<TransitionPlan>> jumpPlans{};
+
+        /* Edges own their plans and lastEdge points into them, so archetypes only move */
+        Archetype() = default;
+        Archetype(const Archetype &) = delete;
+        Archetype & operator=(const Archetype &) = delete;
+        Archetype(Archetype &&) = default;
+        Archetype & operator=(Archetype &&) = default;
+
         void generateHash()
         {
             Hasher h;
@@ -47,16 +140,23 @@ namespace ecs
             }
             hash_value = h.get();
         }
-    };
 
-    struct ArchetypeTransition
-    {
-        uint16_t from_at{};
-        uint16_t to_at{};
+        ArchetypeEdge & getEdge(component_id_t componentId)
+        {
+            if (lastEdge && lastEdgeComponent == componentId) {
+                return *lastEdge;
+            }
+            lastEdge = &edges[componentId];
+            lastEdgeComponent = componentId;
+            return *lastEdge;
+        }
 
-        std::vector<component_id_t> removeComponents{};
-        std::vector<component_id_t> addComponents{};
-        std::vector<component_id_t> preserveComponents{};
+        void clearEdges()
+        {
+            edges.clear();
+            jumpPlans.clear();
+            lastEdge = nullptr;
+        }
     };
 
     struct ArchetypeManager
@@ -65,141 +165,183 @@ namespace ecs
         {
             Archetype e;
             e.generateHash();
+            generateSignature(e);
 
             auto ix = archetypes.size();
-            e.id = static_cast<uint16_t>(ix);
-            emptyArchetype = static_cast<uint16_t>(ix);
+            e.id = static_cast<archetype_id_t>(ix);
+            emptyArchetype = static_cast<archetype_id_t>(ix);
             archetypeMap.emplace(e.hash_value, emptyArchetype);
-            archetypes.push_back(e);
+            archetypes.push_back(std::move(e));
         }
 
-        ArchetypeTransition startTransition(uint16_t at)
+        /* The hash only picks a chain, archetypes on it are compared by signature so a collision
+         * can't merge two different component sets */
+        archetype_id_t findOrCreateArchetype(std::set<component_id_t> && components)
         {
-            ArchetypeTransition trans;
-            trans.from_at = at;
-            trans.to_at = at;
-            auto a = archetypes[at];
-            for (auto s: a.components) {
-                trans.preserveComponents.push_back(s);
+            Archetype archetype;
+            archetype.components = std::move(components);
+            archetype.generateHash();
+            generateSignature(archetype);
+
+            archetype_id_t head = noArchetype;
+            if (auto it = archetypeMap.find(archetype.hash_value); it != archetypeMap.end()) {
+                head = it->second;
             }
+            for (auto candidate = head; candidate != noArchetype; candidate = archetypes[candidate].nextWithHash) {
+                if (archetypes[candidate].signature.words == archetype.signature.words) {
+                    return candidate;
+                }
+            }
+
+            assert(archetypes.size() < noArchetype);
+            auto ix = static_cast<archetype_id_t>(archetypes.size());
+            archetype.id = ix;
+            archetype.nextWithHash = head;
+            archetypeMap.insert_or_assign(archetype.hash_value, ix);
+            archetypes.push_back(std::move(archetype));
 
-            return trans;
+            return ix;
         }
 
-        void createRemoveCache(uint16_t at, component_id_t componentId)
+        /* Stop handing out an archetype, e.g. once one of its components is gone. The archetype
+         * itself stays in place so ids don't shift. */
+        void forgetArchetype(archetype_id_t at)
         {
-            auto old_archetype = archetypes[at];
-            Archetype new_archetype = old_archetype;
-
-            assert(new_archetype.components.find(componentId) != new_archetype.components.end());
-
-            new_archetype.components.erase(componentId);
-            Hasher h;
-            for (auto & v: new_archetype.components) {
-                h.u64(v);
+            const auto hash = archetypes[at].hash_value;
+            auto it = archetypeMap.find(hash);
+            if (it == archetypeMap.end()) {
+                return;
             }
-            new_archetype.hash_value = h.get();
-
-            uint16_t newid;
 
-            if (archetypeMap.find(new_archetype.hash_value) != archetypeMap.end()) {
-                newid = archetypeMap[new_archetype.hash_value];
+            if (it->second == at) {
+                if (archetypes[at].nextWithHash == noArchetype) {
+                    archetypeMap.erase(it);
+                } else {
+                    it->second = archetypes[at].nextWithHash;
+                }
             } else {
-                auto ix = static_cast<uint16_t>(archetypes.size());
-                archetypeMap.emplace(new_archetype.hash_value, ix);
-                new_archetype.id = ix;
-                archetypes.push_back(new_archetype);
-
-                newid = ix;
+                for (auto prev = it->second; prev != noArchetype; prev = archetypes[prev].nextWithHash) {
+                    if (archetypes[prev].nextWithHash == at) {
+                        archetypes[prev].nextWithHash = archetypes[at].nextWithHash;
+                        break;
+                    }
+                }
             }
-
-            removeCache.insert_or_assign({at, componentId}, newid);
+            archetypes[at].nextWithHash = noArchetype;
         }
 
-        void createAddCache(uint16_t at, component_id_t componentId)
+        /* Edge for adding componentId to at, with edge.add resolved. The reverse edge is filled in
+         * at the same time. Edges live in node maps so the reference survives new archetypes. */
+        ArchetypeEdge & addEdge(archetype_id_t at, component_id_t componentId)
         {
-            auto oldAt = archetypes[at];
-            Archetype newA = oldAt;
-            newA.components.insert(componentId);
-            Hasher h;
-            for (auto& v : newA.components) {
-                h.u64(v);
+            auto & edge = archetypes[at].getEdge(componentId);
+            if (edge.add != noArchetype) {
+                return edge;
             }
 
-            uint16_t newId;
+            auto components = archetypes[at].components;
+            components.insert(componentId);
+            const auto to = findOrCreateArchetype(std::move(components));
 
-            newA.hash_value = h.get();
-            if (archetypeMap.contains(newA.hash_value)) {
-                newId = archetypeMap[newA.hash_value];
-            }
-            else {
+            edge.add = to;
+            archetypes[to].getEdge(componentId).remove = at;
 
-                auto ix = static_cast<uint16_t>(archetypes.size());
-                newA.id = ix;
-                //emptyArchetype = ix;
-                archetypeMap.emplace(newA.hash_value, ix);
-                archetypes.push_back(newA);
+            return edge;
+        }
 
-                newId = ix;
+        ArchetypeEdge & removeEdge(archetype_id_t at, component_id_t componentId)
+        {
+            auto & edge = archetypes[at].getEdge(componentId);
+            if (edge.remove != noArchetype) {
+                return edge;
             }
 
-            addCache.insert_or_assign({ at, componentId }, newId);
+            assert(archetypes[at].components.contains(componentId));
+
+            auto components = archetypes[at].components;
+            components.erase(componentId);
+            const auto to = findOrCreateArchetype(std::move(components));
+
+            edge.remove = to;
+            archetypes[to].getEdge(componentId).add = at;
+
+            return edge;
         }
 
-        void removeComponentFromArchetype(component_id_t componentId, ArchetypeTransition & trans)
+        /* Needed once archetypes are dropped, edges may point at them */
+        void clearEdges()
         {
-            if (!removeCache.contains({trans.to_at, componentId})) {
-
-                createRemoveCache(trans.to_at, componentId);
+            for (auto & archetype: archetypes) {
+                archetype.clearEdges();
             }
+        }
 
-            trans.to_at = removeCache[{trans.to_at, componentId}];
+        Archetype & getArchetypeDetails(archetype_id_t id)
+        {
+            return archetypes[id];
+        }
 
-            auto j = std::find(trans.preserveComponents.begin(), trans.preserveComponents.end(), componentId);
+        /* Components get a small dense index the first time an archetype contains them (or a query
+         * asks for them). Signatures and table column slots are addressed by it. */
+        static constexpr uint32_t invalidComponentIndex = std::numeric_limits<uint32_t>::max();
 
-            if (j != trans.preserveComponents.end()) {
-                trans.preserveComponents.erase(j);
-                trans.removeComponents.push_back(componentId);
-            } else {
-                auto k = std::find(trans.addComponents.begin(), trans.addComponents.end(), componentId);
-                assert(k != trans.addComponents.end());
-                trans.addComponents.erase(k);
-            }
+        [[nodiscard]] uint32_t getComponentIndex(component_id_t componentId) const
+        {
+            const auto i = index(componentId);
+            return i < componentIndices.size() ? componentIndices[i] : invalidComponentIndex;
         }
 
-        void addComponentToArchetype(component_id_t componentId, ArchetypeTransition& trans)
+        uint32_t ensureComponentIndex(component_id_t componentId)
         {
-            if (!addCache.contains({ trans.to_at, componentId })) {
-
-                createAddCache(trans.to_at, componentId);
+            const auto i = index(componentId);
+            if (i >= componentIndices.size()) {
+                componentIndices.resize(i + 1, invalidComponentIndex);
             }
+            if (componentIndices[i] == invalidComponentIndex) {
+                componentIndices[i] = componentIndexCount++;
+            }
+            return componentIndices[i];
+        }
 
-            trans.to_at = addCache[{trans.to_at, componentId}];
-
-            auto j = std::find(trans.removeComponents.begin(), trans.removeComponents.end(), componentId);
+        /* The entity slot may be recycled, don't let a later entity inherit the index */
+        void releaseComponentIndex(component_id_t componentId)
+        {
+            const auto i = index(componentId);
+            if (i < componentIndices.size()) {
+                componentIndices[i] = invalidComponentIndex;
+            }
+        }
 
-            if (j != trans.removeComponents.end()) {
-                trans.removeComponents.erase(j);
+        void generateSignature(Archetype & archetype)
+        {
+            archetype.signature.words.clear();
+            for (auto componentId: archetype.components) {
+                archetype.signature.set(ensureComponentIndex(componentId));
             }
-            else {
-                auto k = std::find(trans.preserveComponents.begin(), trans.preserveComponents.end(), componentId);
-                (void)k;
-                assert(k == trans.preserveComponents.end());
-                trans.addComponents.push_back(componentId);
+        }
+
+        template<typename Container>
+        ComponentSignature makeSignature(const Container & components)
+        {
+            ComponentSignature signature;
+            for (auto componentId: components) {
+                signature.set(ensureComponentIndex(componentId));
             }
+            return signature;
         }
 
-        Archetype & getArchetypeDetails(uint16_t id)
+        [[nodiscard]] bool hasComponent(archetype_id_t at, component_id_t componentId) const
         {
-            return archetypes[id];
+            const auto componentIndex = getComponentIndex(componentId);
+            return componentIndex != invalidComponentIndex && archetypes[at].signature.test(componentIndex);
         }
 
         std::vector<Archetype> archetypes{};
-        robin_hood::unordered_map<Hash, uint16_t> archetypeMap;
+        robin_hood::unordered_map<Hash, archetype_id_t> archetypeMap;
 
-        robin_hood::unordered_map<robin_hood::pair<uint16_t, component_id_t>, uint16_t> addCache;
-        robin_hood::unordered_map<robin_hood::pair<uint16_t, component_id_t>, uint16_t> removeCache;
+        archetype_id_t emptyArchetype;
 
-        uint16_t emptyArchetype;
+        std::vector<uint32_t> componentIndices{};
+        uint32_t componentIndexCount = 0;
     };
 }
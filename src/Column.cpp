@@ -23,7 +23,9 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include "Column.h"
 #include "World.h"
 
@@ -36,39 +38,109 @@ namespace ecs
         const auto cd = world->getComponentDetails(componentId);
 
         componentSize = cd->size;
-        alignment = cd->alignment;
-        componentConstructor = cd->componentConstructor;
-        componentDestructor = cd->componentDestructor;
-        componentCopier = cd->componentCopier;
-        componentMover = cd->componentMover;
-        componentAllocator = cd->allocator;
-        componentDeallocator = cd->deallocator;
+        alignment = cd->columnAlignment;
+        functions = cd->functions;
+        triviallyCopyable = cd->triviallyCopyable;
+        triviallyDestructible = cd->triviallyDestructible;
+        triviallyConstructible = cd->triviallyConstructible;
 
-        auto const initial_size = 10;
-
-        ptr = static_cast<std::byte *>(cd->allocator(initial_size));
         count = 0;
-        allocated = initial_size;
+        allocated = 0;
     }
 
     Column::~Column()
     {
-        componentDestructor(ptr, componentSize, count);
-        componentDeallocator(ptr, allocated);
-        ptr = nullptr;
+        clear();
+        for (size_t i = 0; i < pages.size(); i++) {
+            world->getAllocator()->deallocate(pages[i], pageCapacity(i) * componentSize, alignment);
+            world->getAllocator()->deallocate(tickPages[i], pageCapacity(i) * sizeof(RowTicks), alignof(RowTicks));
+        }
+        pages.clear();
+        tickPages.clear();
+    }
+
+    size_t Column::pageCapacity(const size_t page) const
+    {
+        assert(page < pages.size());
+        return page == 0 ? std::min<size_t>(allocated, pageRows) : pageRows;
+    }
+
+    uint32_t Column::pageRowCount(const size_t page) const
+    {
+        const auto start = static_cast<uint32_t>(page << pageShift);
+        if (start >= count) {
+            return 0;
+        }
+        return std::min(count - start, pageRows);
+    }
+
+    std::byte * Column::allocatePage(const size_t rows) const
+    {
+        return static_cast<std::byte *>(world->getAllocator()->allocate(rows * componentSize, alignment));
+    }
+
+    Column::RowTicks * Column::allocateTickPage(const size_t rows) const
+    {
+        return static_cast<RowTicks *>(world->getAllocator()->allocate(rows * sizeof(RowTicks), alignof(RowTicks)));
+    }
+
+    void Column::addPage()
+    {
+        pages.push_back(allocatePage(pageRows));
+        tickPages.push_back(allocateTickPage(pageRows));
+        allocated += pageRows;
     }
 
     void Column::enlargeMemory()
     {
-        const size_t new_size = allocated * 3 / 2 + 1;
-        const auto new_ptr = componentAllocator(new_size);
+        if (pages.empty()) {
+            auto const initial_size = 10;
+
+            resizeFirstPage(initial_size);
+            return;
+        }
+
+        if (allocated < pageRows) {
+            // Still filling the first page, grow it in place up to a full page
+            resizeFirstPage(std::min<size_t>(allocated * 3 / 2 + 1, pageRows));
+            return;
+        }
+
+        addPage();
+    }
+
+    void Column::resizeFirstPage(const size_t rows)
+    {
+        assert(rows <= pageRows && rows > allocated);
 
-        componentMover(ptr, new_ptr, componentSize, count);
-        componentDestructor(ptr, componentSize, count);
-        componentDeallocator(ptr, allocated);
+        const auto new_ptr = allocatePage(rows);
+        const auto new_ticks = allocateTickPage(rows);
+        if (!pages.empty()) {
+            moveRows(pages[0], new_ptr, count);
+            destroyRows(pages[0], count);
+            std::copy_n(tickPages[0], count, new_ticks);
+            world->getAllocator()->deallocate(pages[0], allocated * componentSize, alignment);
+            world->getAllocator()->deallocate(tickPages[0], allocated * sizeof(RowTicks), alignof(RowTicks));
+            pages[0] = new_ptr;
+            tickPages[0] = new_ticks;
+        } else {
+            pages.push_back(new_ptr);
+            tickPages.push_back(new_ticks);
+        }
+        allocated = rows;
+    }
 
-        allocated = new_size;
-        ptr = static_cast<std::byte *>(new_ptr);
+    void Column::reserve(const size_t rows)
+    {
+        if (rows <= allocated) {
+            return;
+        }
+        if (allocated < pageRows) {
+            resizeFirstPage(std::min<size_t>(std::max<size_t>(rows, allocated * 3 / 2 + 1), pageRows));
+        }
+        while (allocated < rows) {
+            addPage();
+        }
     }
 
     size_t Column::addMoveEntry(void * srcPtr)
@@ -79,9 +151,10 @@ namespace ecs
             enlargeMemory();
         }
 
-        void * dest_ptr = ptr + count * componentSize;
-        componentMover(srcPtr, dest_ptr, componentSize, 1);
-        return count++;
+        void * dest_ptr = getEntry(count++);
+        moveRows(srcPtr, dest_ptr, 1);
+        appendTicks(count - 1);
+        return count - 1;
     }
 
     size_t Column::addCopyEntry(void * srcPtr)
@@ -92,9 +165,10 @@ namespace ecs
             enlargeMemory();
         }
 
-        void * dest_ptr = ptr + count * componentSize;
-        componentCopier(srcPtr, dest_ptr, componentSize, 1);
-        return count++;
+        void * dest_ptr = getEntry(count++);
+        copyRows(srcPtr, dest_ptr, 1);
+        appendTicks(count - 1);
+        return count - 1;
     }
 
     size_t Column::addEntry()
@@ -105,38 +179,204 @@ namespace ecs
             enlargeMemory();
         }
 
-        void * dest_ptr = ptr + count * componentSize;
+        void * dest_ptr = getEntry(count++);
 
-        componentConstructor(dest_ptr, componentSize, 1);
-        return count++;
+        constructRows(dest_ptr, 1);
+        appendTicks(count - 1);
+        return count - 1;
+    }
+
+    size_t Column::addUnconstructedEntry()
+    {
+        assert(count <= allocated);
+
+        if (count == allocated) {
+            enlargeMemory();
+        }
+        count++;
+        appendTicks(count - 1);
+        return count - 1;
+    }
+
+    size_t Column::addEntries(const uint32_t rows)
+    {
+        reserve(static_cast<size_t>(count) + rows);
+
+        const uint32_t first = count;
+        count += rows;
+
+        uint32_t row = first;
+        while (row < count) {
+            const uint32_t run = std::min(count - row, pageRows - (row & pageMask));
+            constructRows(getEntry(row), run);
+            row += run;
+        }
+        appendTicks(first);
+        return first;
+    }
+
+    size_t Column::addFillEntries(const void * srcPtr, const uint32_t rows)
+    {
+        reserve(static_cast<size_t>(count) + rows);
+
+        const uint32_t first = count;
+        count += rows;
+
+        uint32_t row = first;
+        while (row < count) {
+            const uint32_t run = std::min(count - row, pageRows - (row & pageMask));
+            fillRows(srcPtr, getEntry(row), run);
+            row += run;
+        }
+        appendTicks(first);
+        return first;
+    }
+
+    size_t Column::addMoveEntries(Column & source)
+    {
+        assert(source.componentId == componentId);
+        reserve(static_cast<size_t>(count) + source.count);
+
+        const uint32_t first = count;
+        count += source.count;
+
+        uint32_t row = first;
+        uint32_t from = 0;
+        while (from < source.count) {
+            const uint32_t run = std::min(
+                {source.count - from, pageRows - (row & pageMask), pageRows - (from & pageMask)}
+            );
+            moveRows(source.getEntry(from), getEntry(row), run);
+            std::copy_n(&source.getTicks(from), run, &getTicks(row));
+            from += run;
+            row += run;
+        }
+        source.clear();
+        return first;
     }
 
     void Column::removeEntry(const uint32_t row, const bool destroy)
     {
         assert(row < count);
         if (row == count - 1) {
-            void * dest_ptr = ptr + row * componentSize;
+            void * dest_ptr = getEntry(row);
             if (destroy) {
-                componentDestructor(dest_ptr, componentSize, 1);
+                destroyRows(dest_ptr, 1);
             }
             count--;
             return;
         }
 
-        void * dest_ptr = ptr + row * componentSize;
-        void * src_ptr = ptr + (count - 1) * componentSize;
+        void * dest_ptr = getEntry(row);
+        void * src_ptr = getEntry(count - 1);
 
         if (destroy) {
-            componentDestructor(dest_ptr, componentSize, 1);
+            destroyRows(dest_ptr, 1);
         }
-        componentMover(src_ptr, dest_ptr, componentSize, 1);
-        componentDestructor(src_ptr, componentSize, 1);
+        moveRows(src_ptr, dest_ptr, 1);
+        destroyRows(src_ptr, 1);
+        getTicks(row) = getTicks(count - 1);
         count--;
     }
 
+    void Column::copyTicks(const uint32_t row, const Column & source, const uint32_t sourceRow)
+    {
+        getTicks(row) = source.getTicks(sourceRow);
+    }
+
+    void Column::appendTicks(const uint32_t first) const
+    {
+        const auto tick = world->getChangeTick();
+        uint32_t row = first;
+        while (row < count) {
+            const uint32_t run = std::min(count - row, pageRows - (row & pageMask));
+            std::fill_n(&getTicks(row), run, RowTicks{tick, tick});
+            row += run;
+        }
+    }
+
+    void Column::markChanged(const uint32_t first, const uint32_t rows, const tick_t tick) const
+    {
+        const uint32_t end = first + rows;
+        uint32_t row = first;
+        while (row < end) {
+            const uint32_t run = std::min(end - row, pageRows - (row & pageMask));
+            RowTicks * ticks = &getTicks(row);
+            for (uint32_t i = 0; i < run; i++) {
+                ticks[i].changed = tick;
+            }
+            row += run;
+        }
+    }
+
+    void Column::clampTicks(const tick_t now) const
+    {
+        const tick_t oldest = now - maxTickAge;
+        for (uint32_t row = 0; row < count; row++) {
+            auto & ticks = getTicks(row);
+            if (now - ticks.added > maxTickAge) {
+                ticks.added = oldest;
+            }
+            if (now - ticks.changed > maxTickAge) {
+                ticks.changed = oldest;
+            }
+        }
+    }
+
+    void Column::constructRows(void * ptr, const uint32_t rows) const
+    {
+        if (triviallyConstructible) {
+            // Matches the value initialisation done by componentConstructor
+            std::memset(ptr, 0, static_cast<size_t>(rows) * componentSize);
+            return;
+        }
+        functions->constructor(ptr, componentSize, rows);
+    }
+
+    void Column::destroyRows(void * ptr, const uint32_t rows) const
+    {
+        if (triviallyDestructible) {
+            return;
+        }
+        functions->destructor(ptr, componentSize, rows);
+    }
+
+    void Column::copyRows(const void * src, void * dest, const uint32_t rows) const
+    {
+        if (triviallyCopyable) {
+            std::memcpy(dest, src, static_cast<size_t>(rows) * componentSize);
+            return;
+        }
+        functions->copier(src, dest, componentSize, rows);
+    }
+
+    void Column::moveRows(void * src, void * dest, const uint32_t rows) const
+    {
+        if (triviallyCopyable) {
+            std::memcpy(dest, src, static_cast<size_t>(rows) * componentSize);
+            return;
+        }
+        functions->mover(src, dest, componentSize, rows);
+    }
+
+    void Column::fillRows(const void * src, void * dest, const uint32_t rows) const
+    {
+        if (triviallyCopyable) {
+            auto * out = static_cast<std::byte *>(dest);
+            for (uint32_t i = 0; i < rows; i++) {
+                std::memcpy(out, src, componentSize);
+                out += componentSize;
+            }
+            return;
+        }
+        functions->filler(src, dest, componentSize, rows);
+    }
+
     void Column::clear()
     {
-        componentDestructor(ptr, componentSize, count);
+        for (size_t i = 0; i < pages.size(); i++) {
+            destroyRows(pages[i], pageRowCount(i));
+        }
         count = 0;
     }
 
@@ -144,7 +384,7 @@ namespace ecs
     {
         assert(row < count);
 
-        void * dest_ptr = ptr + row * componentSize;
+        void * dest_ptr = pages[row >> pageShift] + (row & pageMask) * componentSize;
         return dest_ptr;
     }
 
@@ -152,7 +392,23 @@ namespace ecs
     {
         assert(row < count);
 
-        void * dest_ptr = ptr + row * componentSize;
-        componentCopier(srcPtr, dest_ptr, componentSize, 1);
+        void * dest_ptr = getEntry(row);
+        if (triviallyCopyable) {
+            std::memcpy(dest_ptr, srcPtr, componentSize);
+            return;
+        }
+        functions->assigner(srcPtr, dest_ptr, componentSize, 1);
+    }
+
+    void Column::setEntryMoved(const uint32_t row, void * srcPtr) const
+    {
+        assert(row < count);
+
+        void * dest_ptr = getEntry(row);
+        if (triviallyCopyable) {
+            std::memcpy(dest_ptr, srcPtr, componentSize);
+            return;
+        }
+        functions->moveAssigner(srcPtr, dest_ptr, componentSize, 1);
     }
 }
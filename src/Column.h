@@ -25,10 +25,11 @@
 
 #pragma once
 
-#include <functional>
+#include <algorithm>
 #include <span>
 #include <vector>
 
+#include "Component.h"
 #include "Entity.h"
 //#include "World.h"
 
@@ -38,37 +39,118 @@ namespace ecs
 
     struct Column
     {
+        /* Rows are stored in fixed size pages so that growing a column never relocates rows that
+         * already live in a full page. Only the first page grows (up to pageRows) to keep small
+         * tables small. */
+        static constexpr uint32_t pageShift = 10;
+        static constexpr uint32_t pageRows = 1u << pageShift;
+        static constexpr uint32_t pageMask = pageRows - 1;
+
         component_id_t componentId;
         World * world;
 
         uint32_t componentSize;
+        /* Every page starts on this boundary, see getAlignment() */
         uint16_t alignment;
 
-        std::function<void(void *, size_t, uint32_t)> componentConstructor;
-        std::function<void(void *, size_t, uint32_t)> componentDestructor;
-        std::function<void(const void *, void *, size_t, uint32_t)> componentCopier;
-        std::function<void(void *, void *, size_t, uint32_t)> componentMover;
+        const ComponentFunctions * functions;
+
+        bool triviallyCopyable;
+        bool triviallyDestructible;
+        bool triviallyConstructible;
 
-        std::function<void *(size_t)> componentAllocator;
-        std::function<void(void *, size_t)> componentDeallocator;
+        /* World::getChangeTick() at the time a row was added and last written */
+        struct RowTicks
+        {
+            tick_t added;
+            tick_t changed;
+        };
 
-        std::byte * ptr;
+        /* Ticks only mean anything within maxTickAge of the current tick. The world clamps older
+         * ones every tickCheckInterval ticks, so a wrapped tick never reads as newer. */
+        static constexpr tick_t tickCheckInterval = 1u << 30;
+        static constexpr tick_t maxTickAge = ~tick_t{0} - (2 * tickCheckInterval - 1);
+
+        std::vector<std::byte *> pages;
+        /* One page of ticks per page of rows, with the same capacity */
+        std::vector<RowTicks *> tickPages;
         uint32_t count;
         size_t allocated;
 
         Column(component_id_t componentId, World * world);
         ~Column();
         void enlargeMemory();
+        void resizeFirstPage(size_t rows);
+        void reserve(size_t rows);
+        [[nodiscard]] std::byte * allocatePage(size_t rows) const;
+        [[nodiscard]] RowTicks * allocateTickPage(size_t rows) const;
+        void addPage();
         size_t addMoveEntry(void * srcPtr);
         size_t addCopyEntry(void * srcPtr);
         size_t addEntry();
+        /* Appends a row without constructing it, the caller constructs it in place */
+        size_t addUnconstructedEntry();
+        /* Appends default constructed rows, constructing a page run at a time */
+        size_t addEntries(uint32_t rows);
+        /* Appends rows that are all copies of one source row */
+        size_t addFillEntries(const void * srcPtr, uint32_t rows);
+        /* Moves every row of source onto the end of this column, leaving source empty */
+        size_t addMoveEntries(Column & source);
         void removeEntry(uint32_t row, bool destroy);
+        /* Carries a row's ticks over when it moves in from another column */
+        void copyTicks(uint32_t row, const Column & source, uint32_t sourceRow);
+
+        [[nodiscard]] RowTicks & getTicks(const uint32_t row) const
+        {
+            return tickPages[row >> pageShift][row & pageMask];
+        }
+
+        void markChanged(const uint32_t row, const tick_t tick) const
+        {
+            getTicks(row).changed = tick;
+        }
+
+        void markChanged(uint32_t first, uint32_t rows, tick_t tick) const;
+
+        /* Whether tick is after the after tick, both taken no older than maxTickAge before now */
+        [[nodiscard]] static constexpr bool tickNewer(const tick_t tick, const tick_t after, const tick_t now)
+        {
+            return std::min<tick_t>(now - after, maxTickAge) > std::min<tick_t>(now - tick, maxTickAge);
+        }
+
+        /* Pulls ticks older than maxTickAge up to it */
+        void clampTicks(tick_t now) const;
+
         void * getEntry(uint32_t row) const;
+        /* Assign onto a live row */
         void setEntry(uint32_t row, const void * srcPtr) const;
+        void setEntryMoved(uint32_t row, void * srcPtr) const;
 
         void clear();
+        /* Stamps rows from first to the end with the current change tick */
+        void appendTicks(uint32_t first) const;
+
+        void constructRows(void * ptr, uint32_t rows) const;
+        void destroyRows(void * ptr, uint32_t rows) const;
+        void copyRows(const void * src, void * dest, uint32_t rows) const;
+        void moveRows(void * src, void * dest, uint32_t rows) const;
+        void fillRows(const void * src, void * dest, uint32_t rows) const;
+
+        /* Guaranteed alignment of the first row of every page, and so of every TableView span */
+        [[nodiscard]] uint16_t getAlignment() const
+        {
+            return alignment;
+        }
+
+        [[nodiscard]] size_t pageCount() const
+        {
+            return pages.size();
+        }
+
+        [[nodiscard]] size_t pageCapacity(size_t page) const;
+        [[nodiscard]] uint32_t pageRowCount(size_t page) const;
 
         template<class T>
-        std::span<const T> getComponentData();
+        std::span<const T> getComponentData(uint32_t startRow, uint32_t rowCount);
     };
 }
@@ -35,13 +35,17 @@
 namespace ecs
 {
     template<class T>
-    std::span<const T> Column::getComponentData()
+    std::span<const T> Column::getComponentData(uint32_t startRow, uint32_t rowCount)
     {
-        //component_id_t cid = world->getComponentId<T>();
-
-        //bool b1 = world->getComponentId<T>() == componentId;
         assert((world->getComponentId<T>() == componentId));
-        const T* x = reinterpret_cast<const T*>(ptr);
-        return std::span<const T>(x, count);
+        assert(startRow + rowCount <= count);
+        if (rowCount == 0) {
+            return {};
+        }
+        // A span can only cover rows that share a page
+        assert((startRow >> pageShift) == ((startRow + rowCount - 1) >> pageShift));
+
+        const T * x = static_cast<const T *>(getEntry(startRow));
+        return std::span<const T>(x, rowCount);
     }
 }
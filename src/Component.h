@@ -25,6 +25,7 @@
 
 #pragma once
 
+#include <bit>
 #include <cassert>
 #include <string>
 #include <memory>
@@ -36,22 +37,50 @@
 
 namespace ecs
 {
+    /* One static table of lifetime hooks per component type, shared by every column */
+    struct ComponentFunctions
+    {
+        void (* constructor)(void *, size_t, uint32_t);
+        void (* destructor)(void *, size_t, uint32_t);
+        void (* copier)(const void *, void *, size_t, uint32_t);
+        void (* mover)(void *, void *, size_t, uint32_t);
+        /* Copy constructs count rows from one source row */
+        void (* filler)(const void *, void *, size_t, uint32_t);
+        /* Copy and move assign onto live rows */
+        void (* assigner)(const void *, void *, size_t, uint32_t);
+        void (* moveAssigner)(void *, void *, size_t, uint32_t);
+    };
+
+    /* Columns are at least cache line aligned. Specialise ColumnAlignment for a component to ask
+     * for more, e.g. for wide vector loads over its column data. */
+    inline constexpr uint16_t defaultColumnAlignment = 64;
+
+    template<typename T>
+    struct ColumnAlignment
+        : std::integral_constant<uint16_t, (alignof(T) > defaultColumnAlignment)
+                                           ? static_cast<uint16_t>(alignof(T))
+                                           : defaultColumnAlignment>
+    {
+    };
+
     struct Component
     {
         std::string name;
         uint32_t size;
         uint16_t alignment;
+        uint16_t columnAlignment;
 
-        std::function<void(void *, size_t, uint32_t)> componentConstructor;
-        std::function<void(void *, size_t, uint32_t)> componentDestructor;
-        std::function<void(const void *, void *, size_t, uint32_t)> componentCopier;
-        std::function<void(void *, void *, size_t, uint32_t)> componentMover;
+        const ComponentFunctions * functions;
 
         bool isRelation;
 
-        std::function<void* (size_t)> allocator;
-        std::function<void(void *,size_t)> deallocator;
-        //std::allocator<Component> alloc;
+        /* Empty types only take part in archetype identity, tables give them no column */
+        bool isTag;
+
+        /* Captured at registration so columns can use memcpy/memset and skip destructors */
+        bool triviallyCopyable;
+        bool triviallyDestructible;
+        bool triviallyConstructible;
 
         std::vector<entity_t> onAdds{};
         std::vector<entity_t> onUpdates{};
@@ -59,23 +88,6 @@ namespace ecs
         //std::vector<entity_t> onDelete{};
     };
 
-    template<class T>
-    void * componentAllocator(size_t n)
-    {
-        std::allocator<T> a;
-        return a.allocate(n);
-        //return std::allocator_traits<std::allocator<T>>::allocate(n);
-    }
-
-    template<class T>
-    void componentDeallocator(void * p, size_t n)
-    {
-        std::allocator<T> a;
-
-        return a.deallocate(static_cast<T *>(p), n);
-        //return std::allocator_traits<std::allocator<T>>::deallocate(p, n);
-    }
-
     template <typename T>
     void componentConstructor(
         void * ptr,
@@ -148,6 +160,74 @@ namespace ecs
         }
     }
 
+    template <typename T>
+    void componentFill(
+        const void * src,
+        void * dest,
+        const size_t size,
+        const uint32_t count
+    )
+    {
+        (void) size;
+        assert(size == sizeof(T));
+
+        std::span<T> dest_components(static_cast<T *>(dest), count);
+        const T & source_component = *static_cast<const T *>(src);
+
+        for (auto & component: dest_components) {
+            std::construct_at(&component, source_component);
+        }
+    }
+
+    template <typename T>
+    void componentAssign(
+        const void * src,
+        void * dest,
+        const size_t size,
+        const uint32_t count
+    )
+    {
+        (void) size;
+        assert(size == sizeof(T));
+
+        std::span<T> dest_components(static_cast<T *>(dest), count);
+        std::span<const T> source_components(static_cast<const T *>(src), count);
+
+        for (uint32_t i = 0; i < dest_components.size(); i++) {
+            dest_components[i] = source_components[i];
+        }
+    }
+
+    template <typename T>
+    void componentMoveAssign(
+        void * src,
+        void * dest,
+        const size_t size,
+        const uint32_t count
+    )
+    {
+        (void) size;
+        assert(size == sizeof(T));
+
+        std::span<T> dest_components(static_cast<T *>(dest), count);
+        std::span<T> source_components(static_cast<T *>(src), count);
+
+        for (uint32_t i = 0; i < dest_components.size(); i++) {
+            dest_components[i] = std::move(source_components[i]);
+        }
+    }
+
+    template<typename T>
+    inline constexpr ComponentFunctions componentFunctions{
+        componentConstructor<T>,
+        componentDestructor<T>,
+        componentCopy<T>,
+        componentMove<T>,
+        componentFill<T>,
+        componentAssign<T>,
+        componentMoveAssign<T>
+    };
+
     struct Name
     {
         std::string name;
@@ -166,4 +246,22 @@ namespace ecs
     {
         
     };
+
+    template<typename T>
+    Component describeComponent(std::string name)
+    {
+        static_assert(ColumnAlignment<T>::value >= alignof(T), "Column alignment too small");
+        static_assert(std::has_single_bit(ColumnAlignment<T>::value), "Column alignment must be a power of 2");
+
+        return Component{
+            std::move(name),
+            sizeof(T), alignof(T), ColumnAlignment<T>::value,
+            &componentFunctions<T>,
+            std::is_base_of_v<Relation, T>,
+            std::is_empty_v<T>,
+            std::is_trivially_copyable_v<T>,
+            std::is_trivially_destructible_v<T>,
+            std::is_trivially_default_constructible_v<T>
+        };
+    }
 }
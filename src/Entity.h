@@ -8,6 +8,9 @@ namespace ecs
     using component_id_t = uint64_t;
     using queryid_t = uint64_t;
     using systemid_t  = uint64_t;
+    using archetype_id_t = uint32_t;
+    /* World change tick, wraps, see Column::tickNewer */
+    using tick_t = uint32_t;
 
     inline uint32_t version(const entity_t id)
     {
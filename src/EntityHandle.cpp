@@ -35,7 +35,7 @@ namespace ecs
         return world->isAlive(id);
     }
 
-    EntityHandle::operator unsigned long long() const
+    EntityHandle::operator entity_t() const
     {
         return id;
     }
@@ -25,6 +25,7 @@
 
 #pragma once
 #include <string>
+#include <type_traits>
 #include <vector>
 #include <functional>
 
@@ -44,8 +45,20 @@ namespace ecs
         template<typename T>
         EntityHandle & set(const T & v);
 
+        template<typename T> requires (!std::is_reference_v<T>)
+        EntityHandle & set(T && v);
+
+        template<typename ... Ts> requires (sizeof...(Ts) > 1 && (!std::is_pointer_v<Ts> && ...))
+        EntityHandle & set(const Ts & ... values);
+
+        template<typename T, typename ... Args>
+        EntityHandle & emplace(Args && ... args);
+
         template<typename T>
         EntityHandle & add();
+
+        template<typename ... Ts> requires (sizeof...(Ts) > 1)
+        EntityHandle & add();
         //EntityHandle & addDynamic(component_id_t id);
         EntityHandle & addParent(component_id_t id);
 
@@ -37,12 +37,40 @@ namespace ecs
         return *this;
     }
 
+    template<typename T> requires (!std::is_reference_v<T>)
+    EntityHandle & EntityHandle::set(T && v)
+    {
+        world->set<T>(id, std::move(v));
+        return *this;
+    }
+
+    template<typename ... Ts> requires (sizeof...(Ts) > 1 && (!std::is_pointer_v<Ts> && ...))
+    EntityHandle & EntityHandle::set(const Ts & ... values)
+    {
+        world->set(id, values...);
+        return *this;
+    }
+
+    template<typename T, typename ... Args>
+    EntityHandle & EntityHandle::emplace(Args && ... args)
+    {
+        world->emplace<T>(id, std::forward<Args>(args)...);
+        return *this;
+    }
+
     template<typename T>
     EntityHandle & EntityHandle::add()
     {
         world->add<T>(id);
         return *this;
     }
+
+    template<typename ... Ts> requires (sizeof...(Ts) > 1)
+    EntityHandle & EntityHandle::add()
+    {
+        world->add<Ts...>(id);
+        return *this;
+    }
 #if 0
     template<typename T>
     T * EntityHandle::addAndUpdate()
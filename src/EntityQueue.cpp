@@ -43,6 +43,15 @@ namespace ecs
 
         entries.push_back({id, false});
     }
+
+    void EntityQueue::add(std::span<const entity_t> ids)
+    {
+        std::lock_guard g(mutex);
+
+        for (auto id: ids) {
+            entries.push_back({id, false});
+        }
+    }
 #if 0
     void EntityQueue::remove(entity_t id)
     {
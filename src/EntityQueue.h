@@ -32,6 +32,7 @@
 
 #include <functional>
 #include <mutex>
+#include <span>
 #include "Entity.h"
 #include "EntityHandle.h"
 
@@ -50,6 +51,7 @@ namespace ecs {
         std::mutex mutex{};
 
         void add(entity_t id);
+        void add(std::span<const entity_t> ids);
 #if 0
         void remove(entity_t id);
 #endif
@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////////////////////////
+// MIT License
+//
+// Copyright (c) 2021.  Shane Hyde (shane@noctonyx.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cassert>
+#include <memory>
+#include <vector>
+
+#include "Entity.h"
+
+namespace ecs
+{
+    /* The fields looked up on every entity access, 16 bytes so a record never straddles a line */
+    struct EntityEntry
+    {
+        uint32_t version;
+        /* Table row while alive, the next free slot while dead */
+        uint32_t row;
+        archetype_id_t archetype;
+        bool alive;
+    };
+
+    /* Entity records indexed by entity index. Records live in fixed size pages so growing never
+     * moves existing ones, and the rarely read update sequence is kept in its own pages. */
+    class EntityStore
+    {
+    public:
+        static constexpr uint32_t pageShift = 12;
+        static constexpr uint32_t pageSize = 1u << pageShift;
+        static constexpr uint32_t pageMask = pageSize - 1;
+
+        [[nodiscard]] uint32_t size() const
+        {
+            return count;
+        }
+
+        /* Appends a zeroed record and returns its index */
+        uint32_t add()
+        {
+            if ((count & pageMask) == 0) {
+                hotPages.push_back(std::make_unique<EntityEntry[]>(pageSize));
+                coldPages.push_back(std::make_unique<uint64_t[]>(pageSize));
+            }
+            return count++;
+        }
+
+        EntityEntry & operator[](const uint32_t i)
+        {
+            assert(i < count);
+            return hotPages[i >> pageShift][i & pageMask];
+        }
+
+        const EntityEntry & operator[](const uint32_t i) const
+        {
+            assert(i < count);
+            return hotPages[i >> pageShift][i & pageMask];
+        }
+
+        uint64_t & updateSequence(const uint32_t i)
+        {
+            assert(i < count);
+            return coldPages[i >> pageShift][i & pageMask];
+        }
+
+        [[nodiscard]] uint64_t updateSequence(const uint32_t i) const
+        {
+            assert(i < count);
+            return coldPages[i >> pageShift][i & pageMask];
+        }
+
+    private:
+        std::vector<std::unique_ptr<EntityEntry[]>> hotPages{};
+        std::vector<std::unique_ptr<uint64_t[]>> coldPages{};
+        uint32_t count = 0;
+    };
+
+    static_assert(sizeof(EntityEntry) == 16);
+}
@@ -26,12 +26,33 @@
 #pragma once
 
 #include <iterator>
+#include <memory>
 #include <vector>
 #include "Entity.h"
 #include "World.h"
+#include "QueryResult.h"
 
 namespace ecs
 {
+    /* Holds the QueryResult reused by system and stream dispatch. It is derived state, so a
+     * copied Query starts without one. */
+    struct CachedQueryResult
+    {
+        std::unique_ptr<QueryResult> result{};
+
+        CachedQueryResult() = default;
+        CachedQueryResult(const CachedQueryResult &) {}
+        CachedQueryResult(CachedQueryResult &&) noexcept = default;
+
+        CachedQueryResult & operator=(const CachedQueryResult &)
+        {
+            result.reset();
+            return *this;
+        }
+
+        CachedQueryResult & operator=(CachedQueryResult &&) noexcept = default;
+    };
+
     struct Query
     {
         std::set<component_id_t> with;
@@ -40,38 +61,46 @@ namespace ecs
         std::set<std::pair<component_id_t, std::set<component_id_t>>> relations{};
         std::unordered_map<component_id_t, component_id_t> relationLookup;
 
+        /* Subsets of with, matching only rows whose column tick is newer than the last system run */
+        std::set<component_id_t> changed{};
+        std::set<component_id_t> added{};
+
         bool inheritance = false;
         bool thread = false;
 
-        std::vector<Table *> tables{};
+        /* with/without as signatures, rebuilt by recalculateQuery */
+        ComponentSignature withSignature{};
+        ComponentSignature withoutSignature{};
 
-        bool interestedInArchetype(Archetype & ad)
-        {
-            std::vector<component_id_t> with_overlap;
-            std::vector<component_id_t> without_overlap;
+        std::vector<Table *> tables{};
 
-            std::ranges::set_intersection(ad.components, with, std::back_inserter(with_overlap));
+        /* Built on first dispatch, dropped whenever the query definition changes. Table list
+         * and row count changes only rebuild its views. */
+        mutable CachedQueryResult cachedResult{};
 
-            if (with_overlap.size() < with.size()) {
-                return false;
-            }
-
-            std::ranges::set_intersection(ad.components, without,
-                                          std::back_inserter(without_overlap));
-            if (without_overlap.empty()) {
-                return true;
-            }
+        void invalidateResults() const
+        {
+            cachedResult.result.reset();
+        }
 
-            return false;
+        [[nodiscard]] bool interestedInArchetype(const Archetype & ad) const
+        {
+            return ad.signature.containsAll(withSignature) && !ad.signature.intersects(withoutSignature);
         }
 
         void recalculateQuery(World * world)
         {
+            invalidateResults();
             tables.clear();
 
+            withSignature = world->am.makeSignature(with);
+            withoutSignature = world->am.makeSignature(without);
+
             for (auto & i: *world) {
                 if (interestedInArchetype(i)) {
-                    tables.push_back(world->getTableForArchetype(i.id));
+                    if (auto table = world->getTableForArchetype(i.id)) {
+                        tables.push_back(table);
+                    }
                 }
             }
 
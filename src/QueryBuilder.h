@@ -38,6 +38,14 @@ namespace ecs
         template <class ... TArgs>
         QueryBuilder & without();
 
+        /* Also requires TArgs, matching rows written or added since the system last ran. Writes
+         * are set, emplace, update and mutable each parameters, not raw getUpdate pointers. */
+        template <class ... TArgs>
+        QueryBuilder & changed();
+
+        template <class ... TArgs>
+        QueryBuilder & added();
+
 #if 0
         template <class ... TArgs>
         QueryBuilder& with();
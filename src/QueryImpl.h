@@ -46,6 +46,39 @@ namespace ecs
 
         return *this;
     }
+
+    template <class ... TArgs>
+    QueryBuilder & QueryBuilder::changed()
+    {
+        std::vector<component_id_t> changed = {world->getComponentId<TArgs>()...};
+        world->update<Query>(id, [&](Query * qp){
+            for (auto c: changed) {
+                qp->with.insert(c);
+                if (qp->changed.insert(c).second) {
+                    world->trackChanges(c);
+                }
+            }
+            qp->recalculateQuery(world);
+        });
+
+        return *this;
+    }
+
+    template <class ... TArgs>
+    QueryBuilder & QueryBuilder::added()
+    {
+        std::vector<component_id_t> added = {world->getComponentId<TArgs>()...};
+        world->update<Query>(id, [&](Query * qp){
+            for (auto c: added) {
+                qp->with.insert(c);
+                qp->added.insert(c);
+            }
+            qp->recalculateQuery(world);
+        });
+
+        return *this;
+    }
+
 #if 0
     template <class ... TArgs>
     QueryBuilder & QueryBuilder::with()
@@ -71,6 +104,7 @@ namespace ecs
 
         world->update<Query>(id, [=](Query * qp){
             qp->relations.insert({relative, targets});
+            qp->invalidateResults();
         });
 
         return *this;
@@ -84,6 +118,7 @@ namespace ecs
             for (auto w: singleton) {
                 qp->singleton.insert(w);
             }
+            qp->invalidateResults();
         });
 
         return *this;
@@ -115,6 +150,7 @@ namespace ecs
     {
         world->update<Query>(id, [=](Query * qp){
             qp->inheritance = inherit;
+            qp->invalidateResults();
         });
 
         return *this;
@@ -124,6 +160,7 @@ namespace ecs
     {
         world->update<Query>(id, [](Query * qp){
             qp->thread = true;
+            qp->invalidateResults();
         });
         return *this;
     }
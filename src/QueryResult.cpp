@@ -39,31 +39,20 @@ namespace ecs
         const std::set<component_id_t> & with,
         const std::set<std::pair<component_id_t, std::set<component_id_t>>> & withRelations,
         const std::set<component_id_t> & withSingletons,
+        const std::set<component_id_t> & changed,
+        const std::set<component_id_t> & added,
         bool inherit,
         bool thread
     )
         : world(world)
         , inheritance(inherit)
         , thread(thread)
+        , changeTick(world->getChangeTick())
+        , changedAfter(changeTick - Column::maxTickAge)
+        , changedTerms(changed.begin(), changed.end())
+        , addedTerms(added.begin(), added.end())
     {
-        total = 0;
-        for (auto table: tableList) {
-            size_t startRow = 0;
-            size_t viewSize = std::max(table->entities.size() / 40, 1024ULL);
-            while (startRow < table->entities.size()) {
-                auto & newView = tableViews.emplace_back();
-                newView.world = world;
-                newView.table = table;
-                newView.tableUpdateTimestamp = table->lastUpdateTimestamp;
-                newView.startRow = startRow;
-                newView.count = std::min(table->entities.size() - startRow, viewSize);
-                for (auto w: with) {
-                    components.insert(w);
-                }
-                startRow += newView.count;
-            }
-            total += static_cast<uint32_t>(table->entities.size());
-        }
+        refresh(tableList);
         for (auto w: with) {
             components.insert(w);
         }
@@ -79,6 +68,52 @@ namespace ecs
         }
     }
 
+    void QueryResult::refresh(const std::vector<Table *> & tableList)
+    {
+        tableViews.clear();
+        total = 0;
+        for (auto table: tableList) {
+            TableView::appendTableViews(world, table, tableViews);
+            total += static_cast<uint32_t>(table->entities.size());
+        }
+        updatedAfter = 0;
+        processed = 0;
+        changeTick = world->getChangeTick();
+        changedAfter = changeTick - Column::maxTickAge;
+    }
+
+    bool QueryResult::hasUpdates() const
+    {
+        if (updatedAfter == 0) {
+            return true;
+        }
+        const Table * last = nullptr;
+        for (auto & view: tableViews) {
+            if (view.table != last && view.table->maxUpdateSequence > updatedAfter) {
+                return true;
+            }
+            last = view.table;
+        }
+        return false;
+    }
+
+    bool QueryResult::passesTickTerms(const Table * table, const uint32_t row) const
+    {
+        for (auto c: changedTerms) {
+            auto * column = table->getColumn(c);
+            if (column && !Column::tickNewer(column->getTicks(row).changed, changedAfter, changeTick)) {
+                return false;
+            }
+        }
+        for (auto c: addedTerms) {
+            auto * column = table->getColumn(c);
+            if (column && !Column::tickNewer(column->getTicks(row).added, changedAfter, changeTick)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     void * QueryResult::checkTables(TableView & view,
                                     const component_id_t componentId,
                                     const uint32_t row,
@@ -24,8 +24,11 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #pragma once
+#include <algorithm>
 #include <cstdint>
 #include <set>
+#include <span>
+#include <tuple>
 #include <unordered_set>
 #include <vector>
 #include <array>
@@ -63,11 +66,42 @@ constexpr auto get_mutable_parameters(T)
     return get_mutable_parameters(&T::operator());
 }
 
+/* Chunk callbacks take their mutability from the requested types, slot 0 stands in for the
+ * entity parameter */
+template<class... T>
+constexpr auto get_chunk_mutable_parameters()
+{
+    return std::array{false, !std::is_const_v<T>...};
+}
+
 namespace ecs
 {
     struct TableView;
     struct QueryResult;
 
+    /* A run of contiguous rows from one table, spans indexed like Ts. A component the table
+     * doesn't store, such as an absent optional one, gets an empty span. */
+    template<typename ... Ts>
+    struct Chunk
+    {
+        World * world;
+        std::span<const entity_t> entities;
+        std::tuple<std::span<Ts>...> columns;
+        uint32_t count;
+
+        template<std::size_t I>
+        [[nodiscard]] auto column() const
+        {
+            return std::get<I>(columns);
+        }
+
+        template<typename T>
+        [[nodiscard]] std::span<T> get() const
+        {
+            return std::get<std::span<T>>(columns);
+        }
+    };
+
     struct TableViewIterator
     {
         uint32_t row;
@@ -103,7 +137,14 @@ namespace ecs
         uint64_t updatedAfter = 0;
         uint32_t processed = 0;
 
+        /* Column ticks for changed<>/added<> terms, and the tick stamped on mutable parameters */
+        tick_t changeTick;
+        tick_t changedAfter = 0;
+        std::vector<component_id_t> changedTerms;
+        std::vector<component_id_t> addedTerms;
+
         std::unordered_map<component_id_t, std::vector<EntityQueue *>> updateTriggers;
+        bool hasUpdateTriggers = false;
 
     public:
         uint32_t total;
@@ -117,15 +158,37 @@ namespace ecs
                     const std::set<component_id_t> & with,
                     const std::set<std::pair<component_id_t, std::set<component_id_t>>> & relations,
                     const std::set<component_id_t> & singletons,
+                    const std::set<component_id_t> & changed,
+                    const std::set<component_id_t> & added,
                     bool inheritance,
                     bool thread
         );
 
+        /* Rebuilds the table views over tableList and resets per run state, reusing storage */
+        void refresh(const std::vector<Table *> & tableList);
+
         void onlyUpdatedAfter(uint64_t seq)
         {
             updatedAfter = seq;
         }
 
+        /* Checks the table and page summaries, so views with nothing newer than updatedAfter are
+         * never walked */
+        [[nodiscard]] bool viewUpdated(const TableView & view) const
+        {
+            return updatedAfter == 0 || view.table->pageUpdatedAfter(view.startRow, updatedAfter);
+        }
+
+        [[nodiscard]] bool hasUpdates() const;
+
+        void onlyChangedAfter(tick_t tick)
+        {
+            changedAfter = tick;
+        }
+
+        /* Tags have no column, so a changed<>/added<> term on a tag always passes */
+        [[nodiscard]] bool passesTickTerms(const Table * table, uint32_t row) const;
+
         [[nodiscard]] uint32_t count() const
         {
             return total;
@@ -196,14 +259,87 @@ namespace ecs
         template<typename ... U, typename Func>
         void each(Func && f);
 
+        /* Calls f with a Chunk<Ts...> per run of rows. Const Ts are read only, like const
+         * parameters to each. */
+        template<typename ... Ts, typename Func>
+        void eachChunk(Func && f);
+
+        template<typename ... Ts, typename Func, std::size_t ... I>
+        uint32_t eachChunkView(Func && f,
+                               const std::array<component_id_t, sizeof...(Ts)> & comps,
+                               const std::array<bool, sizeof...(Ts) + 1> & stamp,
+                               const TableView & view,
+                               std::index_sequence<I...>) const;
+
+        /* Runs processView over each view, spread over jobs for threaded queries */
+        template<typename ViewFunc>
+        void dispatchViews(ViewFunc && processView);
+
+        template<typename T>
+        static std::span<T> columnSpan(Column * column, const uint32_t row, const uint32_t rows)
+        {
+            return column ? std::span<T>(static_cast<T *>(column->getEntry(row)), rows) : std::span<T>();
+        }
+
+        /* Taken per view when every requested component is a column of the table. Walks typed
+         * pointers over the view's contiguous rows, checks validity once per view and marks
+         * ticks and posts update triggers for the whole view when no filter applies. */
+        template<typename ... U, typename Func, std::size_t ... I>
+        uint32_t eachDense(Func && f,
+                           const std::array<component_id_t, sizeof...(U)> & comps,
+                           const std::array<bool, sizeof...(U) + 1> & stamp,
+                           const std::array<Column *, sizeof...(U)> & columns,
+                           const TableView & view,
+                           std::index_sequence<I...>) const;
+
+        /* withUpdates and changed<>/added<> row filters */
+        [[nodiscard]] bool filtered() const
+        {
+            return updatedAfter > 0 || !changedTerms.empty() || !addedTerms.empty();
+        }
+
+        [[nodiscard]] bool passesFilters(const Table * table, uint32_t row, entity_t ent) const
+        {
+            if (updatedAfter > 0 && world->entities.updateSequence(index(ent)) <= updatedAfter) {
+                return false;
+            }
+            return passesTickTerms(table, row);
+        }
+
+        template<size_t N>
+        void postUpdateTriggers(const std::array<component_id_t, N> & comps, std::span<const entity_t> ids) const
+        {
+            for (auto c: comps) {
+                auto it = updateTriggers.find(c);
+                if (it != updateTriggers.end()) {
+                    for (auto t: it->second) {
+                        t->add(ids);
+                    }
+                }
+            }
+        }
+
         template<typename ... U, typename Func>
         uint32_t eachView(Func && f,
                           const std::array<component_id_t, sizeof...(U)> & comps,
                           const std::array<bool, sizeof...(U) + 1> & mp,
+                          const std::array<bool, sizeof...(U) + 1> & stamp,
                           const TableView & view) const;
 
         template<size_t I>
         void setupUpdateTriggerLists(std::array<component_id_t, I> & comps, const std::array<bool, I + 1> & mp);
+
+        /* Mutable parameters whose changed ticks someone reads, see World::tracksChanges */
+        template<size_t I>
+        [[nodiscard]] std::array<bool, I + 1> stampedParameters(const std::array<component_id_t, I> & comps,
+                                                                const std::array<bool, I + 1> & mp) const
+        {
+            std::array<bool, I + 1> stamp{};
+            for (size_t i = 0; i < I; i++) {
+                stamp[i + 1] = mp[i + 1] && world->tracksChanges(comps[i]);
+            }
+            return stamp;
+        }
     };
 
     template<typename Tuple, std::size_t I>
@@ -221,6 +357,10 @@ namespace ecs
             std::get<I>(t) = static_cast<std::tuple_element_t<I, Tuple>>(col->getEntry(row));
             return;
         }
+        if (view.table->hasComponent(componentId)) {
+            std::get<I>(t) = static_cast<std::tuple_element_t<I, Tuple>>(Table::tagPlaceholder());
+            return;
+        }
 
         if (!result_ptr) {
             result_ptr = checkRelations(view, row, componentId, mutate);
@@ -256,17 +396,25 @@ namespace ecs
     uint32_t QueryResult::eachView(Func && f,
                                    const std::array<component_id_t, sizeof...(U)> & comps,
                                    const std::array<bool, sizeof...(U) + 1> & mp,
+                                   const std::array<bool, sizeof...(U) + 1> & stamp,
                                    const TableView & tableView) const
     {
         uint32_t proc = 0;
+        if (!viewUpdated(tableView)) {
+            return proc;
+        }
         auto columns = tableView.getColumns<U...>(comps);
+        if constexpr ((!std::is_empty_v<U> && ...)) {
+            if (std::all_of(columns.begin(), columns.end(), [](const Column * c) { return c != nullptr; })) {
+                return eachDense<U...>(f, comps, stamp, columns, tableView, std::make_index_sequence<sizeof...(U)>());
+            }
+        }
+        const bool checkFilters = filtered();
 
         for (auto row: tableView) {
             entity_t ent = tableView.entity(row);
-            if (updatedAfter > 0) {
-                if (world->entities[index(ent)].updateSequence <= updatedAfter) {
-                    continue;
-                }
+            if (checkFilters && !passesFilters(tableView.table, row, ent)) {
+                continue;
             }
             //for(size_t row = tableView.startRow; row < tableView.count + tableView.startRow; row++){
             std::tuple<EntityHandle, U * ...> result;
@@ -276,43 +424,81 @@ namespace ecs
                 std::make_index_sequence<sizeof...(U)>()
             );
             std::apply(f, result);
-            for(auto c: comps) {
-                auto it = updateTriggers.find(c);
-                if(it != updateTriggers.end()) {
-                    //auto & v = it->second;
-                    for(auto t: it->second) {
-                        t->add(ent);
-                    }
+            for (size_t i = 0; i < sizeof...(U); i++) {
+                if (stamp[i + 1] && columns[i]) {
+                    columns[i]->markChanged(row, changeTick);
                 }
             }
+            if (hasUpdateTriggers) {
+                postUpdateTriggers(comps, std::span<const entity_t>(&ent, 1));
+            }
             proc++;
         }
 
         return proc;
     }
 
-    template<typename ... U, typename Func>
-    void QueryResult::each(Func && f)
+    template<typename ... U, typename Func, std::size_t ... I>
+    uint32_t QueryResult::eachDense(Func && f,
+                                    const std::array<component_id_t, sizeof...(U)> & comps,
+                                    const std::array<bool, sizeof...(U) + 1> & stamp,
+                                    const std::array<Column *, sizeof...(U)> & columns,
+                                    const TableView & view,
+                                    std::index_sequence<I...>) const
     {
-        std::array<component_id_t, sizeof...(U)> comps = {
-            world->getComponentId<std::remove_const_t<U>>()...
-        };
-        std::array<bool, sizeof...(U)+1> mp = get_mutable_parameters(f);
+        view.checkValidity();
 
-        setupUpdateTriggerLists(comps, mp);
+        const auto start = static_cast<uint32_t>(view.startRow);
+        const auto count = static_cast<uint32_t>(view.count);
+        const std::span<const entity_t> ids(view.table->entities.data() + start, count);
+        const std::tuple<U * ...> first{static_cast<U *>(columns[I]->getEntry(start))...};
+
+        uint32_t proc = 0;
+        if (!filtered()) {
+            for (uint32_t i = 0; i < count; i++) {
+                f(EntityHandle{ids[i], world}, (std::get<I>(first) + i)...);
+            }
+            proc = count;
+            ((stamp[I + 1] ? columns[I]->markChanged(start, count, changeTick) : void()), ...);
+            if (hasUpdateTriggers) {
+                postUpdateTriggers(comps, ids);
+            }
+        } else {
+            for (uint32_t i = 0; i < count; i++) {
+                if (!passesFilters(view.table, start + i, ids[i])) {
+                    continue;
+                }
+                f(EntityHandle{ids[i], world}, (std::get<I>(first) + i)...);
+                ((stamp[I + 1] ? columns[I]->markChanged(start + i, changeTick) : void()), ...);
+                if (hasUpdateTriggers) {
+                    postUpdateTriggers(comps, ids.subspan(i, 1));
+                }
+                proc++;
+            }
+        }
+
+        view.checkValidity();
+        return proc;
+    }
 
+    template<typename ViewFunc>
+    void QueryResult::dispatchViews(ViewFunc && processView)
+    {
         auto job = world->jobInterface;
 
         if (job && thread && tableViews.size() > 2 && total > 1000) {
             std::vector<JobInterface::JobHandle> jobs;
 
             for (auto & view: *this) {
+                if (!viewUpdated(view)) {
+                    continue;
+                }
                 if(view.count <= 20) {
-                    processed += eachView<U...>(f, comps, mp, view);
+                    processed += processView(view);
                 } else {
                     auto jh = job->create(
-                        [=]() {
-                            return eachView<U...>(f, comps, mp, view);
+                        [&processView, view]() {
+                            return processView(view);
                         }
                         );
 
@@ -329,15 +515,109 @@ namespace ecs
             jobs.clear();
         } else {
             for (auto & view: *this) {
-                processed += eachView<U...>(f, comps, mp, view);
+                processed += processView(view);
             }
         }
     }
 
+    template<typename ... U, typename Func>
+    void QueryResult::each(Func && f)
+    {
+        std::array<component_id_t, sizeof...(U)> comps = {
+            world->getComponentId<std::remove_const_t<U>>()...
+        };
+        std::array<bool, sizeof...(U)+1> mp = get_mutable_parameters(f);
+        const auto stamp = stampedParameters(comps, mp);
+
+        setupUpdateTriggerLists(comps, mp);
+
+        dispatchViews([&](const TableView & view) {
+            return eachView<U...>(f, comps, mp, stamp, view);
+        });
+    }
+
+    template<typename ... Ts, typename Func>
+    void QueryResult::eachChunk(Func && f)
+    {
+        static_assert((!std::is_empty_v<Ts> && ...), "Tags have no column to hand out as a span");
+
+        std::array<component_id_t, sizeof...(Ts)> comps = {
+            world->getComponentId<std::remove_const_t<Ts>>()...
+        };
+        constexpr auto mp = get_chunk_mutable_parameters<Ts...>();
+        const auto stamp = stampedParameters(comps, mp);
+
+        setupUpdateTriggerLists(comps, mp);
+
+        dispatchViews([&](const TableView & view) {
+            return eachChunkView<Ts...>(f, comps, stamp, view, std::make_index_sequence<sizeof...(Ts)>());
+        });
+    }
+
+    template<typename ... Ts, typename Func, std::size_t ... I>
+    uint32_t QueryResult::eachChunkView(Func && f,
+                                        const std::array<component_id_t, sizeof...(Ts)> & comps,
+                                        const std::array<bool, sizeof...(Ts) + 1> & stamp,
+                                        const TableView & view,
+                                        std::index_sequence<I...>) const
+    {
+        uint32_t proc = 0;
+        if (!viewUpdated(view)) {
+            return proc;
+        }
+        view.checkValidity();
+
+        const auto columns = view.getColumns<Ts...>(comps);
+        const auto start = static_cast<uint32_t>(view.startRow);
+        const auto count = static_cast<uint32_t>(view.count);
+        const std::span<const entity_t> ids(view.table->entities.data() + start, count);
+
+        auto emit = [&](const uint32_t first, const uint32_t rows) {
+            const Chunk<Ts...> chunk{
+                world,
+                ids.subspan(first, rows),
+                {columnSpan<Ts>(columns[I], start + first, rows)...},
+                rows
+            };
+            f(chunk);
+            ((stamp[I + 1] && columns[I] ? columns[I]->markChanged(start + first, rows, changeTick) : void()), ...);
+            if (hasUpdateTriggers) {
+                postUpdateTriggers(comps, chunk.entities);
+            }
+            proc += rows;
+        };
+
+        if (!filtered()) {
+            emit(0, count);
+        } else {
+            /* Filtered rows split the view into runs of passing rows */
+            uint32_t runStart = 0;
+            for (uint32_t i = 0; i < count; i++) {
+                if (!passesFilters(view.table, start + i, ids[i])) {
+                    if (i > runStart) {
+                        emit(runStart, i - runStart);
+                    }
+                    runStart = i + 1;
+                }
+            }
+            if (count > runStart) {
+                emit(runStart, count - runStart);
+            }
+        }
+
+        view.checkValidity();
+        return proc;
+    }
+
     template<size_t I>
     void QueryResult::setupUpdateTriggerLists(std::array<component_id_t, I> & comps,
                                               const std::array<bool, I + 1> & mutableParameters)
     {
+        /* Cleared rather than dropped so a cached result refills them without allocating */
+        for (auto & [componentId, queues]: updateTriggers) {
+            queues.clear();
+        }
+        hasUpdateTriggers = false;
         uint32_t i = 0;
         for (auto & c: comps) {
             if (mutableParameters[i + 1]) {
@@ -346,6 +626,7 @@ namespace ecs
                     auto eq = world->getEntityQueue(updateTrigger);
                     if (eq) {
                         updateTriggers[c].push_back(eq);
+                        hasUpdateTriggers = true;
                     }
                 }
             }
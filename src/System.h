@@ -135,6 +135,8 @@ namespace ecs
         std::chrono::time_point<std::chrono::steady_clock> startTime;
 
         uint64_t lastRunSequence = 0;
+        /* World change tick of the last run, the cut off for changed<>/added<> terms */
+        tick_t lastChangeTick = 0;
 
         float interval = 0.f;
         float intervalElapsed = 0.f;
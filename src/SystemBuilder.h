@@ -65,6 +65,13 @@ namespace ecs
 
         template<class ... TArgs>
         SystemBuilder& without();
+
+        /* Only rows whose TArgs were written or added since this system last ran */
+        template<class ... TArgs>
+        SystemBuilder& changed();
+
+        template<class ... TArgs>
+        SystemBuilder& added();
 #if 0
         template<class ... TArgs>
         SystemBuilder& with();
@@ -117,6 +124,10 @@ namespace ecs
         template <typename ... U, typename Func>
         SystemBuilder & each(Func&& f);
 
+        /* f takes a Chunk<Ts...>, const Ts are recorded as reads and the rest as writes */
+        template <typename ... Ts, typename Func>
+        SystemBuilder & eachChunk(Func&& f);
+
         template <typename Func>
         SystemBuilder& execute(Func&& f);
 
@@ -84,6 +84,32 @@ namespace ecs
 
         return *this;
     }
+
+    template<class ... TArgs>
+    SystemBuilder & SystemBuilder::changed()
+    {
+        assert(type == SystemType::Query);
+
+        world->markSystemsDirty();
+
+        assert(q);
+        qb.changed<TArgs...>();
+
+        return withRead<TArgs...>();
+    }
+
+    template<class ... TArgs>
+    SystemBuilder & SystemBuilder::added()
+    {
+        assert(type == SystemType::Query);
+
+        world->markSystemsDirty();
+
+        assert(q);
+        qb.added<TArgs...>();
+
+        return withRead<TArgs...>();
+    }
 #if 0
     template<class ... TArgs>
     SystemBuilder & SystemBuilder::with()
@@ -258,6 +284,37 @@ namespace ecs
         return *this;
     }
 
+    template<typename ... Ts, typename Func>
+    SystemBuilder & SystemBuilder::eachChunk(Func && f)
+    {
+        assert(type == SystemType::Query);
+        assert(q);
+
+        world->update<System>(id, [&](System * s){
+            assert(s->groupId);
+
+            constexpr auto mutableParameters = get_chunk_mutable_parameters<Ts...>();
+            std::array<component_id_t, sizeof...(Ts)> comps = {
+                world->getComponentId<std::remove_const_t<Ts>>() ...
+            };
+
+            for (uint32_t i = 0; i < comps.size(); i++) {
+                if (mutableParameters[i + 1]) {
+                    s->writes.insert(comps[i]);
+                } else {
+                    s->reads.insert(comps[i]);
+                }
+            }
+
+            s->queryProcessor = [=](QueryResult& res) {
+                res.eachChunk<Ts...>(f);
+                return res.getProcessed();
+            };
+        });
+
+        return *this;
+    }
+
     template<typename Func>
     SystemBuilder & SystemBuilder::execute(Func && f)
     {
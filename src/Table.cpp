@@ -5,13 +5,28 @@
 
 namespace ecs
 {
-    Table::Table(World * world, uint16_t archetypeId)
+    Table::Table(World * world, archetype_id_t archetypeId)
         : world(world)
         , archetypeId(archetypeId)
     {
-        auto at = world->am.getArchetypeDetails(archetypeId);
+        auto & at = world->am.getArchetypeDetails(archetypeId);
         for (auto & componentId: at.components) {
-            columns.emplace(componentId, std::make_unique<Column>(componentId, world));
+            if (world->getComponentDetails(componentId)->isTag) {
+                continue;
+            }
+            columns.push_back(makeAllocated<Column>(world->getAllocator(), componentId, world));
+        }
+        assert(columns.size() < noColumn);
+
+        for (uint16_t slot = 0; slot < columns.size(); slot++) {
+            const auto componentIndex = world->getComponentIndex(columns[slot]->componentId);
+            if (componentIndex >= maxSlottedIndex) {
+                continue;
+            }
+            if (componentIndex >= columnSlots.size()) {
+                columnSlots.resize(componentIndex + 1, noColumn);
+            }
+            columnSlots[componentIndex] = slot;
         }
     }
 
@@ -30,71 +45,112 @@ namespace ecs
         auto ix = static_cast<uint32_t>(entities.size());
         world->entities[index(id)].row = ix;
         entities.push_back(id);
-        for (auto & [k, v]: columns) {
-            v->addEntry();
+        for (auto & column: columns) {
+            column->addEntry();
+        }
+        noteUpdate(ix, world->entities.updateSequence(index(id)));
+        stampUpdateTime();
+    }
+
+    uint32_t Table::addEntities(uint32_t count)
+    {
+        const auto first = static_cast<uint32_t>(entities.size());
+        entities.resize(entities.size() + count);
+        for (auto & column: columns) {
+            column->addEntries(count);
         }
         stampUpdateTime();
+        return first;
     }
 
     void Table::removeEntity(entity_t id)
     {
         const uint32_t row = getEntityRow(id);
-        for (auto & [k, v]: columns) {
-            v->removeEntry(row, true);
+        for (auto & column: columns) {
+            column->removeEntry(row, true);
         }
 
         const auto last_entity = entities.back();
 
         entities[row] = last_entity;
         world->entities[index(last_entity)].row = row;
+        noteUpdate(row, world->entities.updateSequence(index(last_entity)));
 
         entities.pop_back();
+        trimUpdateSummaries();
         stampUpdateTime();
     }
 
     bool Table::hasComponent(component_id_t componentId) const
     {
-        auto it = columns.find(componentId);
-
-        return (it != columns.end());
+        return world->am.hasComponent(archetypeId, componentId);
     }
 
-    const void * Table::getComponent(entity_t id, component_id_t componentId)
+    Column * Table::getColumn(component_id_t componentId) const
     {
-        auto it = columns.find(componentId);
-
-        if (it == columns.end()) {
+        const auto componentIndex = world->getComponentIndex(componentId);
+        if (componentIndex >= maxSlottedIndex) {
+            auto it = std::lower_bound(columns.begin(), columns.end(), componentId,
+                                       [](const AllocatorPtr<Column> & column, component_id_t id)
+                                       {
+                                           return column->componentId < id;
+                                       });
+            return it != columns.end() && (*it)->componentId == componentId ? it->get() : nullptr;
+        }
+        if (componentIndex >= columnSlots.size() || columnSlots[componentIndex] == noColumn) {
             return nullptr;
         }
-        const uint32_t row = getEntityRow(id);
-        auto & c = it->second;
+        Column * column = columns[columnSlots[componentIndex]].get();
+
+        /* A recycled entity index can still map to a dead component's slot */
+        return column->componentId == componentId ? column : nullptr;
+    }
+
+    void * Table::tagPlaceholder()
+    {
+        static std::byte placeholder{};
+        return &placeholder;
+    }
 
-        return c->getEntry(row);
+    const void * Table::getComponent(entity_t id, component_id_t componentId)
+    {
+        return getUpdateComponent(id, componentId);
     }
 
     void * Table::getUpdateComponent(entity_t id, component_id_t componentId)
     {
-        if (!columns.contains(componentId)) {
-            return nullptr;
+        auto c = getColumn(componentId);
+        if (!c) {
+            return hasComponent(componentId) ? tagPlaceholder() : nullptr;
         }
-        const uint32_t row = getEntityRow(id);
-        auto & c = columns[componentId];
 
-        return c->getEntry(row);
+        return c->getEntry(getEntityRow(id));
     }
 
     void Table::setComponent(entity_t id, component_id_t componentId, const void * ptr)
     {
-        const uint32_t row = getEntityRow(id);
-        auto & c = columns[componentId];
+        auto c = getColumn(componentId);
+        if (!c) {
+            return;
+        }
+
+        c->setEntry(getEntityRow(id), ptr);
+    }
 
-        c->setEntry(row, ptr);
+    void Table::setComponentMoved(entity_t id, component_id_t componentId, void * ptr)
+    {
+        auto c = getColumn(componentId);
+        if (!c) {
+            return;
+        }
+
+        c->setEntryMoved(getEntityRow(id), ptr);
     }
 
     std::string Table::description() const
     {
         std::string r = "";
-        for (auto & [x, y]: columns) {
+        for (auto & x: world->am.getArchetypeDetails(archetypeId).components) {
             if (r != "") {
                 r += "|";
             }
@@ -111,11 +167,37 @@ namespace ecs
         return world->entities[index(id)].row; // entitiesIndex.at(id);
     }
 
+    TransitionPlan Table::planMove(Table * fromTable, Table * toTable)
+    {
+        TransitionPlan plan;
+        plan.fromTable = fromTable;
+        plan.toTable = toTable;
+
+        /* Both column arrays are sorted by component id, so one merge walk pairs up the columns
+         * to preserve, add and drop */
+        uint16_t from = 0;
+        uint16_t to = 0;
+        const auto fromCount = static_cast<uint16_t>(fromTable->columns.size());
+        const auto toCount = static_cast<uint16_t>(toTable->columns.size());
+        while (from < fromCount || to < toCount) {
+            if (to == toCount
+                || (from < fromCount && fromTable->columns[from]->componentId < toTable->columns[to]->componentId)) {
+                plan.remove.push_back(from++);
+            } else if (from == fromCount || toTable->columns[to]->componentId < fromTable->columns[from]->componentId) {
+                plan.add.push_back(to++);
+            } else {
+                plan.preserve.emplace_back(from++, to++);
+            }
+        }
+        return plan;
+    }
+
     void Table::moveEntity(World * world,
                            Table * fromTable,
                            Table * toTable,
                            entity_t id,
-                           const ArchetypeTransition & trans)
+                           const TransitionPlan & plan,
+                           const Column * unconstructed)
     {
         const auto source_row = fromTable->getEntityRow(id);
 
@@ -124,18 +206,23 @@ namespace ecs
         world->entities[index(id)].row = new_index;
         toTable->entities.push_back(id);
 
-        for (auto & r: trans.removeComponents) {
-            fromTable->columns[r]->removeEntry(source_row, true);
+        for (auto [from, to]: plan.preserve) {
+            auto & fromColumn = fromTable->columns[from];
+            auto & toColumn = toTable->columns[to];
+            const auto row = static_cast<uint32_t>(toColumn->addMoveEntry(fromColumn->getEntry(source_row)));
+            toColumn->copyTicks(row, *fromColumn, source_row);
+            fromColumn->removeEntry(source_row, true);
         }
-
-        for (auto & a: trans.addComponents) {
-            toTable->columns[a]->addEntry();
+        for (auto to: plan.add) {
+            auto & column = toTable->columns[to];
+            if (column.get() == unconstructed) {
+                column->addUnconstructedEntry();
+            } else {
+                column->addEntry();
+            }
         }
-
-        for (auto & e: trans.preserveComponents) {
-            const auto ptr1 = fromTable->columns[e]->getEntry(source_row);
-            toTable->columns[e]->addMoveEntry(ptr1);
-            fromTable->columns[e]->removeEntry(source_row, true);
+        for (auto from: plan.remove) {
+            fromTable->columns[from]->removeEntry(source_row, true);
         }
 
         const auto last_entity = fromTable->entities.back();
@@ -143,34 +230,98 @@ namespace ecs
         if (source_row != fromTable->entities.size() - 1) {
             fromTable->entities[source_row] = last_entity;
             world->entities[index(last_entity)].row = source_row;
+            fromTable->noteUpdate(source_row, world->entities.updateSequence(index(last_entity)));
         }
         fromTable->entities.pop_back();
+        fromTable->trimUpdateSummaries();
+        toTable->noteUpdate(new_index, world->entities.updateSequence(index(id)));
         fromTable->stampUpdateTime();
         toTable->stampUpdateTime();
     }
 
-    void Table::copyEntity(World * world,
-                           const Table * fromTable,
-                           Table * toTable,
-                           entity_t id,
-                           entity_t newEntity,
-                           const ArchetypeTransition & trans)
+    uint32_t Table::moveEntities(World * world, const TransitionPlan & plan)
     {
-        const auto source_row = fromTable->getEntityRow(id);
+        Table * fromTable = plan.fromTable;
+        Table * toTable = plan.toTable;
+        const auto count = static_cast<uint32_t>(fromTable->entities.size());
+
+        if (toTable->entities.empty()) {
+            /* Nothing to merge with, so the destination takes over the column buffers and every
+             * row keeps its index */
+            std::swap(fromTable->entities, toTable->entities);
+            std::swap(fromTable->pageUpdateSequence, toTable->pageUpdateSequence);
+            std::swap(fromTable->maxUpdateSequence, toTable->maxUpdateSequence);
+            for (auto [from, to]: plan.preserve) {
+                std::swap(fromTable->columns[from], toTable->columns[to]);
+            }
+            for (auto to: plan.add) {
+                toTable->columns[to]->addEntries(count);
+            }
+            for (auto from: plan.remove) {
+                fromTable->columns[from]->clear();
+            }
+            fromTable->stampUpdateTime();
+            toTable->stampUpdateTime();
+            return 0;
+        }
 
-        auto new_index = static_cast<uint32_t>(toTable->entities.size());
+        const auto first = static_cast<uint32_t>(toTable->entities.size());
+        toTable->entities.insert(toTable->entities.end(), fromTable->entities.begin(), fromTable->entities.end());
+        for (uint32_t row = first; row < first + count; row++) {
+            const auto i = index(toTable->entities[row]);
+            world->entities[i].row = row;
+            toTable->noteUpdate(row, world->entities.updateSequence(i));
+        }
 
-        world->entities[index(newEntity)].row = new_index;
-        toTable->entities.push_back(newEntity);
+        for (auto [from, to]: plan.preserve) {
+            toTable->columns[to]->addMoveEntries(*fromTable->columns[from]);
+        }
+        for (auto to: plan.add) {
+            toTable->columns[to]->addEntries(count);
+        }
+        for (auto from: plan.remove) {
+            fromTable->columns[from]->clear();
+        }
+
+        fromTable->entities.clear();
+        fromTable->trimUpdateSummaries();
+        fromTable->stampUpdateTime();
+        toTable->stampUpdateTime();
+        return first;
+    }
 
-        for (auto & a: trans.addComponents) {
-            toTable->columns[a]->addEntry();
+    void Table::clear()
+    {
+        for (auto & column: columns) {
+            column->clear();
         }
+        entities.clear();
+        trimUpdateSummaries();
+        stampUpdateTime();
+    }
+
+    uint32_t Table::copyEntities(const Table * fromTable,
+                                 Table * toTable,
+                                 entity_t id,
+                                 uint32_t count)
+    {
+        const auto source_row = fromTable->getEntityRow(id);
+
+        const auto first = static_cast<uint32_t>(toTable->entities.size());
+        toTable->entities.resize(toTable->entities.size() + count);
 
-        for (auto & e: trans.preserveComponents) {
-            const auto ptr1 = fromTable->columns.at(e)->getEntry(source_row);
-            toTable->columns[e]->addCopyEntry(ptr1);
+        auto from = fromTable->columns.begin();
+        for (auto & column: toTable->columns) {
+            while (from != fromTable->columns.end() && (*from)->componentId < column->componentId) {
+                ++from;
+            }
+            if (from != fromTable->columns.end() && (*from)->componentId == column->componentId) {
+                column->addFillEntries((*from)->getEntry(source_row), count);
+            } else {
+                column->addEntries(count);
+            }
         }
         toTable->stampUpdateTime();
+        return first;
     }
 }
@@ -24,8 +24,9 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #pragma once
+#include <algorithm>
+#include <limits>
 #include <vector>
-#include <map>
 
 #include "ArchetypeManager.h"
 #include "Entity.h"
@@ -35,6 +36,7 @@
 #include "robin_hood.h"
 #include "TableIterator.h"
 #include "Column.h"
+#include "WorldAllocator.h"
 
 namespace ecs
 {
@@ -47,46 +49,112 @@ namespace ecs
     struct Table
     {
         World * world;
-        uint32_t archetypeId;
+        archetype_id_t archetypeId;
         std::vector<entity_t> entities;
 
         Timestamp lastUpdateTimestamp;
 
-        std::map<component_id_t, std::unique_ptr<Column>> columns;
+        /* Highest entity update sequence per TableView sized page of rows and over the table.
+         * Raised when a row is written or lands in a page, so it can overstate but never miss. */
+        std::vector<uint64_t> pageUpdateSequence;
+        uint64_t maxUpdateSequence = 0;
 
-        Table(World * world, uint16_t archetypeId);
+        /* Columns sorted by component id, tags have none. columnSlots maps a component's dense
+         * index (World::getComponentIndex) to its position in columns. Indices are never reused,
+         * so only those below maxSlottedIndex get a slot, the rest are found by binary search. */
+        std::vector<AllocatorPtr<Column>> columns;
+        std::vector<uint16_t> columnSlots;
+
+        static constexpr uint16_t noColumn = std::numeric_limits<uint16_t>::max();
+        static constexpr uint32_t maxSlottedIndex = 256;
+
+        Table(World * world, archetype_id_t archetypeId);
 
         TableIterator begin();
         TableIterator end();
 
         void addEntity(entity_t id);
+        /* Appends rows to every column in bulk, the caller fills entities[first, first + count) */
+        uint32_t addEntities(uint32_t count);
         void removeEntity(entity_t id);
 
         bool hasComponent(component_id_t componentId) const;
+        Column * getColumn(component_id_t componentId) const;
         const void * getComponent(entity_t id, component_id_t componentId);
         void * getUpdateComponent(entity_t id, component_id_t componentId);
         void setComponent(entity_t id, component_id_t componentId, const void * ptr);
+        void setComponentMoved(entity_t id, component_id_t componentId, void * ptr);
 
         std::string description() const;
 
+        /* Tags have no storage, lookups of a present tag return this instead of null */
+        static void * tagPlaceholder();
+
         uint32_t getEntityRow(entity_t id) const;
+        /* Slot mapping used by moveEntity, computed once per archetype edge */
+        static TransitionPlan planMove(Table * fromTable, Table * toTable);
+
+        /* The added column given as unconstructed gets a raw row for the caller to construct */
         static void moveEntity(World * world,
                                Table * fromTable,
                                Table * toTable,
                                entity_t id,
-                               const ArchetypeTransition & trans);
+                               const TransitionPlan & plan,
+                               const Column * unconstructed = nullptr);
 
-        static void copyEntity(World * world,
-                               const Table * fromTable,
-                               Table * toTable,
-                               //Table * existingTable,
-                               entity_t id,
-                               entity_t newEntity,
-                               const ArchetypeTransition & trans);
+        /* Moves every row of plan.fromTable to the end of plan.toTable a column at a time,
+         * returns the first destination row. An empty destination just swaps in the source
+         * columns. */
+        static uint32_t moveEntities(World * world, const TransitionPlan & plan);
+
+        /* Destroys every row, the caller releases the entity records */
+        void clear();
+
+        /* Appends count copies of id's row from fromTable, the caller fills
+         * toTable->entities[first, first + count) */
+        static uint32_t copyEntities(const Table * fromTable,
+                                     Table * toTable,
+                                     entity_t id,
+                                     uint32_t count);
 
         void stampUpdateTime()
         {
-            lastUpdateTimestamp = std::chrono::high_resolution_clock::now();
+            lastUpdateTimestamp = std::chrono::steady_clock::now();
+        }
+
+        void noteUpdate(const uint32_t row, const uint64_t sequence)
+        {
+            const auto page = row / Column::pageRows;
+            if (page >= pageUpdateSequence.size()) {
+                pageUpdateSequence.resize(page + 1, 0);
+            }
+            pageUpdateSequence[page] = std::max(pageUpdateSequence[page], sequence);
+            maxUpdateSequence = std::max(maxUpdateSequence, sequence);
+        }
+
+        void noteUpdates(const uint32_t first, const uint32_t count, const uint64_t sequence)
+        {
+            for (uint32_t row = first; row < first + count; row = (row / Column::pageRows + 1) * Column::pageRows) {
+                noteUpdate(row, sequence);
+            }
+        }
+
+        [[nodiscard]] bool pageUpdatedAfter(const size_t startRow, const uint64_t sequence) const
+        {
+            const auto page = startRow / Column::pageRows;
+            return page < pageUpdateSequence.size() && pageUpdateSequence[page] > sequence;
+        }
+
+        /* Drops the summaries of pages left empty by removals */
+        void trimUpdateSummaries()
+        {
+            const auto pages = (entities.size() + Column::pageRows - 1) / Column::pageRows;
+            if (pages < pageUpdateSequence.size()) {
+                pageUpdateSequence.resize(pages);
+            }
+            if (entities.empty()) {
+                maxUpdateSequence = 0;
+            }
         }
     };
 }
@@ -61,6 +61,20 @@ namespace ecs
         return getUpdate(comp, row);
     }
 
+    void TableView::appendTableViews(World * world, Table * table, std::vector<TableView> & views)
+    {
+        size_t startRow = 0;
+        while (startRow < table->entities.size()) {
+            auto & newView = views.emplace_back();
+            newView.world = world;
+            newView.table = table;
+            newView.tableUpdateTimestamp = table->lastUpdateTimestamp;
+            newView.startRow = startRow;
+            newView.count = std::min<size_t>(table->entities.size() - startRow, Column::pageRows);
+            startRow += newView.count;
+        }
+    }
+
     void TableView::checkValidity() const
     {
         if (tableUpdateTimestamp != table->lastUpdateTimestamp) {
@@ -80,11 +94,11 @@ namespace ecs
 #endif
     void * TableView::getUpdate(component_id_t comp, const uint32_t row) const
     {
-        auto c = table->columns.find(comp);
-        if (c == table->columns.end()) {
-            return nullptr;
+        auto c = table->getColumn(comp);
+        if (!c) {
+            return table->hasComponent(comp) ? Table::tagPlaceholder() : nullptr;
         }
 
-        return (*c).second->getEntry(row);
+        return c->getEntry(row);
     }
 }
\ No newline at end of file
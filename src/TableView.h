@@ -76,6 +76,7 @@ namespace ecs
 
         [[nodiscard]] void * getUpdate(component_id_t comp, uint32_t row) const;
 
+        /* Views never cross a column page so column data for the view is contiguous */
         template<typename T>
         std::span<const T> getColumn() const;
 
@@ -87,11 +88,7 @@ namespace ecs
 
             std::transform(
                 comps.begin(), comps.end(), r.begin(), [this](auto & comp) -> Column * {
-                    if (auto it = table->columns.find(comp); it == table->columns.end()) {
-                        return nullptr;
-                    } else {
-                        return it->second.get();
-                    }
+                    return table->getColumn(comp);
                 }
             );
 
@@ -121,6 +118,8 @@ namespace ecs
             return TableViewRowIterator{startRow, this};
         }
 
+        static void appendTableViews(World * world, Table * table, std::vector<TableView> & views);
+
         [[nodiscard]] TableViewRowIterator end() const
         {
             return TableViewRowIterator{startRow + count, this};
@@ -36,11 +36,11 @@ namespace ecs
     std::span<const T> TableView::getColumn() const
     {
         auto cid = world->getComponentId<T>();
-        if (!table->hasComponent(cid)) {
+        Column * col = table->getColumn(cid);
+        if (!col) {
             return {};
         }
-        Column * col = table->columns.at(cid).get();
 
-        return col->getComponentData<T>();
+        return col->getComponentData<T>(static_cast<uint32_t>(startRow), static_cast<uint32_t>(count));
     }
 }
\ No newline at end of file
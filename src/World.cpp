@@ -28,6 +28,10 @@
 #include <cassert>
 #include <deque>
 #include <atomic>
+#include <thread>
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
 
 #include "Query.h"
 #include "QueryResult.h"
@@ -41,11 +45,18 @@
 
 namespace ecs
 {
-    World::World()
+    namespace
+    {
+        std::atomic<uint64_t> nextWorldEpoch{0};
+    }
+
+    World::World(WorldAllocator * worldAllocator)
+        : defaultAllocator(worldAllocator ? nullptr : std::make_unique<PoolAllocator>())
+        , allocator(worldAllocator ? worldAllocator : defaultAllocator.get())
+        , epoch(++nextWorldEpoch)
     {
-        entities.resize(1);
+        entities.add();
         entities[0].alive = true;
-        recycleStart = 0;
         deltaTime_ = 0.f;
         tables.clear();
 
@@ -55,18 +66,9 @@ namespace ecs
         componentBootstrapId = newEntity().id;
         auto v = type_id<Component>(); // std::type_index(typeid(Component));
         componentMap.emplace(v, componentBootstrapId);
-        componentBootstrap = {
-            trimName(typeid(Component).name()),
-            sizeof(Component), alignof(Component),
-            componentConstructor<Component>,
-            componentDestructor<Component>,
-            componentCopy<Component>,
-            componentMove<Component>,
-            false,
-            componentAllocator<Component>,
-            componentDeallocator<Component>
-        };
+        componentBootstrap = describeComponent<Component>(trimName(typeid(Component).name()));
 
+        registerComponentDetails(componentBootstrapId, componentBootstrap);
         set(componentBootstrapId, componentBootstrapId, &componentBootstrap);
         set<Name>(getComponentId<Component>(), {.name = "Component"});
         set<Name>(getComponentId<Name>(), {.name = "Name"});
@@ -93,8 +95,8 @@ namespace ecs
 
         for (auto & [k, v]: singletons) {
             auto cd = getComponentDetails(k);
-            cd->componentDestructor(v, cd->size, 1);
-            delete[] static_cast<char *>(v);
+            cd->functions->destructor(v, cd->size, 1);
+            allocator->deallocate(v, cd->size, cd->alignment);
         }
 #if 0
         for (auto &[k, v]: tables) {
@@ -104,36 +106,28 @@ namespace ecs
         tables.clear();
     }
 
-    EntityHandle World::newEntity(const char * name)
+    entity_t World::allocateEntity(const archetype_id_t archetype)
     {
-        while (recycleStart < entities.size()) {
-            if (!entities[recycleStart].alive) {
-                entities[recycleStart].alive = true;
-                entities[recycleStart].archetype = am.emptyArchetype;
-                entities[recycleStart].updateSequence = 0;
-                auto id = makeId(
-                    static_cast<uint32_t>(recycleStart),
-                    entities[recycleStart].version
-                );
-                tables[am.emptyArchetype]->addEntity(id);
-                if (name) {
-                    nameIndex[name] = id;
-                    set<Name>(id, {name});
-                }
-                return EntityHandle{id, this};
-            }
-            recycleStart++;
+        if (freeEntity != noFreeEntity) {
+            const auto i = freeEntity;
+            auto & entry = entities[i];
+            freeEntity = entry.row;
+            entry.alive = true;
+            entry.archetype = archetype;
+            entities.updateSequence(i) = 0;
+            return makeId(i, entry.version);
         }
 
-        auto i = static_cast<uint32_t>(entities.size());
-        const uint32_t v = 0;
-
-        auto & x = entities.emplace_back();
+        const auto i = entities.add();
+        auto & x = entities[i];
         x.alive = true;
-        x.version = v;
-        x.archetype = am.emptyArchetype;
-        x.updateSequence = 0;
-        auto id = makeId(i, v);
+        x.archetype = archetype;
+        return makeId(i, x.version);
+    }
+
+    EntityHandle World::newEntity(const char * name)
+    {
+        auto id = allocateEntity(am.emptyArchetype);
         tables[am.emptyArchetype]->addEntity(id);
 
         if (name) {
@@ -143,6 +137,39 @@ namespace ecs
         return EntityHandle{id, this};
     }
 
+    std::span<const entity_t> World::spawn(std::span<const component_id_t> componentIds, const uint32_t count)
+    {
+        auto to = am.emptyArchetype;
+        for (auto componentId: componentIds) {
+            if (!am.hasComponent(to, componentId)) {
+                to = am.addEdge(to, componentId).add;
+            }
+        }
+        ensureTableForArchetype(to);
+        Table * table = tables[to].get();
+
+        const auto first = table->addEntities(count);
+        for (uint32_t row = first; row < first + count; row++) {
+            const auto id = allocateEntity(to);
+            entities[index(id)].row = row;
+            entities.updateSequence(index(id)) = updateSequence;
+            table->entities[row] = id;
+        }
+        table->noteUpdates(first, count, updateSequence);
+
+        const std::span<const entity_t> spawned(table->entities.data() + first, count);
+        for (auto componentId: am.getArchetypeDetails(to).components) {
+            auto * cd = componentDetails(componentId);
+            if (cd->onAdds.empty()) {
+                continue;
+            }
+            for (auto id: spawned) {
+                postEntity(id, cd->onAdds);
+            }
+        }
+        return spawned;
+    }
+
     EntityHandle World::newEntityReplace(const char * name)
     {
         auto e = lookup(name);
@@ -154,28 +181,34 @@ namespace ecs
 
     EntityHandle World::instantiate(entity_t prefab)
     {
-        const auto prefabAt = getEntityArchetype(prefab);
-        auto trans = am.startTransition(prefabAt);
+        return {instantiate(prefab, 1).front(), this};
+    }
 
-        am.removeComponentFromArchetype(getComponentId<Prefab>(), trans);
+    std::span<const entity_t> World::instantiate(entity_t prefab, const uint32_t count)
+    {
+        const auto prefabAt = getEntityArchetype(prefab);
+        auto to = am.removeEdge(prefabAt, getComponentId<Prefab>()).remove;
         if (has<Name>(prefab)) {
-            am.removeComponentFromArchetype(getComponentId<Name>(), trans);
+            to = am.removeEdge(to, getComponentId<Name>()).remove;
         }
 
-        auto e = newEntity();
-        tables[getEntityArchetype(e.id)]->removeEntity(e.id);
+        ensureTableForArchetype(to);
+        Table * table = tables[to].get();
+
+        const auto first = Table::copyEntities(tables[prefabAt].get(), table, prefab, count);
+        for (uint32_t row = first; row < first + count; row++) {
+            const auto id = allocateEntity(to);
+            entities[index(id)].row = row;
+            table->entities[row] = id;
+        }
 
-        ensureTableForArchetype(trans.to_at);
-        Table::copyEntity(this, tables[prefabAt].get(), tables[trans.to_at].get(), prefab, e.id,
-                          trans);
-        entities[index(e.id)].archetype = trans.to_at;
-        auto ad = am.getArchetypeDetails(trans.to_at);
-        for(auto tc: ad.components) {
-            auto * cd = getUpdate<Component>(tc);
-            postEntity(e, cd->onAdds);
-            postEntity(e, cd->onUpdates);
+        const std::span<const entity_t> instances(table->entities.data() + first, count);
+        for (auto componentId: am.getArchetypeDetails(to).components) {
+            auto * cd = componentDetails(componentId);
+            postEntities(instances, cd->onAdds);
+            postEntities(instances, cd->onUpdates);
         }
-        return e;
+        return instances;
     }
 
     EntityHandle World::lookup(const char * name)
@@ -227,6 +260,7 @@ namespace ecs
         const auto v = version(id);
         const auto i = index(id);
         (void) v;
+        (void) i;
         assert(isAlive(id));
         assert(i >= 0);
         assert(i < entities.size());
@@ -244,13 +278,102 @@ namespace ecs
         const auto at = getEntityArchetype(id);
         tables[at]->removeEntity(id);
 
+        releaseEntity(id);
+    }
+
+    void World::releaseEntity(const entity_t id)
+    {
+        const auto i = index(id);
         entities[i].alive = false;
         entities[i].version++;
-        if (i < recycleStart) {
-            recycleStart = i;
+        entities[i].row = freeEntity;
+        freeEntity = i;
+    }
+
+    void World::destroyAll(const queryid_t q)
+    {
+        const auto matched = get<Query>(q)->tables;
+
+        const auto nameId = getComponentId<Name>();
+        for (auto * table: matched) {
+            if (table->entities.empty()) {
+                continue;
+            }
+            if (table->hasComponent(getComponentId<HasEntityQueue>())
+                || table->hasComponent(getComponentId<System>())
+                || table->hasComponent(getComponentId<Component>())) {
+                /* These own other state, let destroy() unwind them one at a time */
+                const auto ids = table->entities;
+                for (auto id: ids) {
+                    if (isAlive(id)) {
+                        destroy(id);
+                    }
+                }
+                continue;
+            }
+
+            if (auto * names = table->getColumn(nameId)) {
+                for (uint32_t row = 0; row < table->entities.size(); row++) {
+                    nameIndex.erase(static_cast<const Name *>(names->getEntry(row))->name);
+                }
+            }
+            for (auto id: table->entities) {
+                releaseEntity(id);
+            }
+            table->clear();
+        }
+    }
+
+    void World::addToAll(const queryid_t q, const component_id_t componentId)
+    {
+        const auto matched = get<Query>(q)->tables;
+
+        for (auto * table: matched) {
+            addToTable(table, componentId);
         }
     }
 
+    void World::removeFromAll(const queryid_t q, const component_id_t componentId)
+    {
+        const auto matched = get<Query>(q)->tables;
+
+        for (auto * table: matched) {
+            removeFromTable(table, componentId);
+        }
+    }
+
+    void World::addToTable(Table * table, const component_id_t componentId)
+    {
+        if (table->entities.empty() || table->hasComponent(componentId)) {
+            return;
+        }
+        const auto at = table->archetypeId;
+        auto & edge = am.addEdge(at, componentId);
+        auto moved = moveTable(at, edge.add, edge.addPlan);
+
+        auto * cd = componentDetails(componentId);
+        postEntities(moved, cd->onAdds);
+    }
+
+    void World::removeFromTable(Table * table, const component_id_t componentId)
+    {
+        if (table->entities.empty() || !table->hasComponent(componentId)) {
+            return;
+        }
+        if (componentId == getComponentId<Name>()) {
+            auto * names = table->getColumn(componentId);
+            for (uint32_t row = 0; row < table->entities.size(); row++) {
+                nameIndex.erase(static_cast<const Name *>(names->getEntry(row))->name);
+            }
+        }
+        const auto at = table->archetypeId;
+        auto & edge = am.removeEdge(at, componentId);
+        auto moved = moveTable(at, edge.remove, edge.removePlan);
+
+        auto * cd = componentDetails(componentId);
+        postEntities(moved, cd->onRemove);
+    }
+
     void World::destroyDeferred(const entity_t id)
     {
         std::lock_guard guard(deferredMutex);
@@ -263,16 +386,49 @@ namespace ecs
             return;
         }
         const auto at = getEntityArchetype(id);
-        auto trans = am.startTransition(at);
+        auto & edge = am.addEdge(at, componentId);
 
-        am.addComponentToArchetype(componentId, trans);
-        setEntityUpdateSequence(id);
-        moveEntity(id, at, trans);
+        auto * table = moveEntity(id, at, edge.add, edge.addPlan);
+        setEntityUpdateSequence(id, table);
 
-        auto * cd = getUpdate<Component>(componentId);
+        auto * cd = componentDetails(componentId);
         postEntity(id, cd->onAdds);
     }
 
+    void World::add(const entity_t id, std::span<const component_id_t> componentIds)
+    {
+        const auto at = getEntityArchetype(id);
+
+        /* Edges are followed without building tables, only the final archetype gets one */
+        auto to = at;
+        ArchetypeEdge * lastEdge = nullptr;
+        uint32_t steps = 0;
+        for (auto componentId: componentIds) {
+            if (am.hasComponent(to, componentId)) {
+                continue;
+            }
+            lastEdge = &am.addEdge(to, componentId);
+            to = lastEdge->add;
+            steps++;
+        }
+        if (steps == 0) {
+            return;
+        }
+
+        auto * table = steps == 1
+                       ? moveEntity(id, at, to, lastEdge->addPlan)
+                       : moveEntity(id, at, to, am.getArchetypeDetails(at).jumpPlans[to]);
+        setEntityUpdateSequence(id, table);
+
+        /* Walks the new archetype rather than componentIds, so a repeated id posts once */
+        for (auto componentId: am.getArchetypeDetails(to).components) {
+            if (!am.hasComponent(at, componentId)) {
+                auto * cd = componentDetails(componentId);
+                postEntity(id, cd->onAdds);
+            }
+        }
+    }
+
     void World::addDeferred(const entity_t id, const component_id_t componentId)
     {
         std::lock_guard guard(deferredMutex);
@@ -283,8 +439,7 @@ namespace ecs
     {
         assert(isAlive(id));
 
-        auto at = getEntityArchetype(id);
-        return am.archetypes[at].components.find(componentId) != am.archetypes[at].components.end();
+        return am.hasComponent(getEntityArchetype(id), componentId);
     }
 
     void World::remove(entity_t id, component_id_t componentId)
@@ -298,12 +453,11 @@ namespace ecs
         }
 
         const auto at = getEntityArchetype(id);
-        auto trans = am.startTransition(at);
-        am.removeComponentFromArchetype(componentId, trans);
-        moveEntity(id, at, trans);
-        setEntityUpdateSequence(id);
+        auto & edge = am.removeEdge(at, componentId);
+        auto * table = moveEntity(id, at, edge.remove, edge.removePlan);
+        setEntityUpdateSequence(id, table);
 
-        auto * cd = getUpdate<Component>(componentId);
+        auto * cd = componentDetails(componentId);
         postEntity(id, cd->onRemove);
     }
 
@@ -350,31 +504,91 @@ namespace ecs
         Table * table = tables[at].get();
 
         void * ptr = table->getUpdateComponent(id, componentId);
-        setEntityUpdateSequence(id);
+        setEntityUpdateSequence(id, table);
         return ptr;
     }
 
     void World::set(entity_t id, component_id_t componentId, const void * ptr)
     {
-        if (componentId != componentBootstrapId && componentId == getComponentId<Name>()) {
-            auto np = static_cast<const Name *>(ptr);
-            nameIndex[np->name] = id;
+        if (has(id, componentId)) {
+            tables[getEntityArchetype(id)]->setComponent(id, componentId, ptr);
+        } else if (auto * row = addUnconstructed(id, componentId)) {
+            tables[getEntityArchetype(id)]->getColumn(componentId)->copyRows(ptr, row, 1);
         }
+        componentWritten(id, componentId, ptr);
+    }
 
-        auto at = getEntityArchetype(id);
-        auto & ad = am.getArchetypeDetails(at);
-        if (ad.components.find(componentId) == ad.components.end()) {
-            add(id, componentId);
-            at = getEntityArchetype(id);
+    void World::setMoved(entity_t id, component_id_t componentId, void * ptr)
+    {
+        if (has(id, componentId)) {
+            tables[getEntityArchetype(id)]->setComponentMoved(id, componentId, ptr);
+        } else if (auto * row = addUnconstructed(id, componentId)) {
+            tables[getEntityArchetype(id)]->getColumn(componentId)->moveRows(ptr, row, 1);
         }
-        assert(tables.contains(at));
-        auto table = tables[at].get();
+        /* ptr is moved from now, so the written row is what gets indexed */
+        componentWritten(id, componentId, tables[getEntityArchetype(id)]->getUpdateComponent(id, componentId));
+    }
+
+    void * World::addUnconstructed(entity_t id, component_id_t componentId)
+    {
+        const auto at = getEntityArchetype(id);
+        auto & edge = am.addEdge(at, componentId);
+        auto & plan = transitionPlan(at, edge.add, edge.addPlan);
+        Column * column = plan.toTable->getColumn(componentId);
 
-        table->setComponent(id, componentId, ptr);
-        setEntityUpdateSequence(id);
+        entities[index(id)].archetype = edge.add;
+        Table::moveEntity(this, plan.fromTable, plan.toTable, id, plan, column);
+        setEntityUpdateSequence(id, plan.toTable);
 
-        auto cd = getUpdate<Component>(componentId);
-        postEntity(id, cd->onUpdates);
+        postEntity(id, componentDetails(componentId)->onAdds);
+        return column ? column->getEntry(plan.toTable->getEntityRow(id)) : nullptr;
+    }
+
+    void World::componentWritten(entity_t id, component_id_t componentId, const void * ptr)
+    {
+        if (componentId == componentBootstrapId) {
+            registerComponentDetails(id, *static_cast<const Component *>(ptr));
+        } else if (componentId == getComponentId<Name>()) {
+            nameIndex[static_cast<const Name *>(ptr)->name] = id;
+        }
+
+        Table * table = tables[getEntityArchetype(id)].get();
+        if (tracksChanges(componentId)) {
+            if (auto * column = table->getColumn(componentId)) {
+                column->markChanged(table->getEntityRow(id), changeTick);
+            }
+        }
+        setEntityUpdateSequence(id, table);
+        postEntity(id, componentDetails(componentId)->onUpdates);
+    }
+
+    void World::markChanged(entity_t id, component_id_t componentId)
+    {
+        if (!tracksChanges(componentId)) {
+            return;
+        }
+        const auto & entry = entities[index(id)];
+        if (auto * column = tables[entry.archetype]->getColumn(componentId)) {
+            column->markChanged(entry.row, changeTick);
+        }
+    }
+
+    void World::trackChanges(component_id_t componentId)
+    {
+        const auto componentIndex = getComponentIndex(componentId);
+        assert(componentIndex != invalidComponentIndex);
+        if (componentIndex >= changeTrackers.size()) {
+            changeTrackers.resize(componentIndex + 1, 0);
+        }
+        changeTrackers[componentIndex]++;
+    }
+
+    void World::untrackChanges(component_id_t componentId)
+    {
+        const auto componentIndex = getComponentIndex(componentId);
+        if (componentIndex < changeTrackers.size() && changeTrackers[componentIndex] > 0) {
+            changeTrackers[componentIndex]--;
+        }
     }
 
     void World::setDeferred(entity_t id, component_id_t componentId, void * ptr)
@@ -389,8 +603,8 @@ namespace ecs
             return;
         }
         auto cd = getComponentDetails(componentId);
-        char * cp = new char[cd->size];
-        cd->componentConstructor(cp, cd->size, 1);
+        void * cp = allocator->allocate(cd->size, cd->alignment);
+        cd->functions->constructor(cp, cd->size, 1);
         singletons[componentId] = cp;
     }
 
@@ -411,9 +625,9 @@ namespace ecs
         auto cd = getComponentDetails(componentId);
         auto ptr = singletons[componentId];
 
-        cd->componentDestructor(ptr, cd->size, 1);
+        cd->functions->destructor(ptr, cd->size, 1);
 
-        delete[] static_cast<char *>(ptr);
+        allocator->deallocate(ptr, cd->size, cd->alignment);
 
         singletons.erase(componentId);
     }
@@ -425,7 +639,7 @@ namespace ecs
         const auto cd = getComponentDetails(componentId);
         const auto p = singletons[componentId];
 
-        cd->componentCopier(ptr, p, cd->size, 1);
+        cd->functions->copier(ptr, p, cd->size, 1);
     }
 
     const void * World::getSingleton(const component_id_t componentId)
@@ -459,28 +673,37 @@ namespace ecs
 
     const Component * World::getComponentDetails(component_id_t id)
     {
-        if (id == componentBootstrapId) {
-            return &componentBootstrap;
+        const auto componentIndex = getComponentIndex(id);
+        if (componentIndex < componentRegistry.size() && componentRegistry[componentIndex].functions) {
+            return &componentRegistry[componentIndex];
         }
         return get<Component>(id);
     }
 
+    Component * World::componentDetails(component_id_t componentId)
+    {
+        const auto componentIndex = getComponentIndex(componentId);
+        assert(componentIndex < componentRegistry.size());
+        return &componentRegistry[componentIndex];
+    }
+
+    void World::registerComponentDetails(component_id_t componentId, const Component & details)
+    {
+        const auto componentIndex = am.ensureComponentIndex(componentId);
+        if (componentIndex >= componentRegistry.size()) {
+            componentRegistry.resize(componentIndex + 1);
+        }
+        componentRegistry[componentIndex] = details;
+    }
+
+    uint16_t World::getColumnAlignment(component_id_t id)
+    {
+        return getComponentDetails(id)->columnAlignment;
+    }
+
     component_id_t World::createDynamicComponent(entity_t entityId)
     {
-        set<Component>(
-            entityId, {
-                description(entityId),
-                sizeof(std::remove_reference_t<DynamicComponent>),
-                alignof(std::remove_reference_t<DynamicComponent>),
-                componentConstructor<std::remove_reference_t<DynamicComponent>>,
-                componentDestructor<std::remove_reference_t<DynamicComponent>>,
-                componentCopy<std::remove_reference_t<DynamicComponent>>,
-                componentMove<std::remove_reference_t<DynamicComponent>>,
-                false,
-                componentAllocator<std::remove_reference_t<DynamicComponent>>,
-                componentDeallocator<std::remove_reference_t<DynamicComponent>>
-            }
-        );
+        set<Component>(entityId, describeComponent<DynamicComponent>(description(entityId)));
 
         return entityId;
     }
@@ -496,7 +719,7 @@ namespace ecs
         assert(res.count() == 0);
         deleteQuery(q.id);
 
-        std::vector<uint16_t> removeList;
+        std::vector<archetype_id_t> removeList;
 
         for (auto & [k, t]: tables) {
 
@@ -506,15 +729,16 @@ namespace ecs
         }
 
         for (auto & r: removeList) {
-            auto at = am.archetypes[r];
-            am.archetypeMap.erase(at.hash_value);
+            am.forgetArchetype(r);
             //auto tab = tables[r];
             //delete tab;
             removeTableFromActiveQueries(tables[r].get());
             tables.erase(r);
         }
-        am.addCache.clear();
-        am.removeCache.clear();
+        am.clearEdges();
+
+        componentRegistry[getComponentIndex(entityId)] = Component{};
+        am.releaseComponentIndex(entityId);
 
         remove<Component>(entityId);
     }
@@ -546,7 +770,8 @@ namespace ecs
             }
         }
         auto s = newEntity();
-        s.set<System>(System{.query = 0, .world = this});
+        /* Everything still in range is newer than a system that never ran */
+        s.set<System>(System{.query = 0, .world = this, .lastChangeTick = changeTick - Column::maxTickAge});
         if (name) {
             s.set<Name>({.name = name});
             nameIndex[name] = s.id;
@@ -564,6 +789,11 @@ namespace ecs
 
     void World::deleteQuery(queryid_t q)
     {
+        if (auto * query = get<Query>(q)) {
+            for (auto c: query->changed) {
+                untrackChanges(c);
+            }
+        }
         destroy(q);
     }
 
@@ -591,10 +821,25 @@ namespace ecs
 
         return QueryResult(
             this, aq->tables, aq->with, aq->relations, aq->singleton,
-            aq->inheritance, aq->thread
+            aq->changed, aq->added, aq->inheritance, aq->thread
         );
     }
 
+    QueryResult & World::getCachedResults(queryid_t q)
+    {
+        assert(isAlive(q));
+        assert(has<Query>(q));
+
+        auto aq = get<Query>(q);
+        auto & cached = aq->cachedResult.result;
+        if (cached) {
+            cached->refresh(aq->tables);
+        } else {
+            cached = std::make_unique<QueryResult>(getResults(q));
+        }
+        return *cached;
+    }
+
     std::optional<JobInterface::JobHandle> World::executeSystem(systemid_t sys)
     {
         if (isAlive(sys)) {
@@ -609,25 +854,34 @@ namespace ecs
                     }
                     system->intervalElapsed -= system->interval;
                 }
-                system->startTime = std::chrono::high_resolution_clock::now();
+                system->startTime = std::chrono::steady_clock::now();
                 //ActiveSystem as(this, system);
 
                 if (system->query) {
-                    auto res = getResults(system->query);
+                    /* Writes made during the run carry their own tick, newer than the cut off
+                     * and older than anything written after it */
+                    const auto tick = ++changeTick;
+                    auto & res = getCachedResults(system->query);
+                    res.onlyChangedAfter(system->lastChangeTick);
                     system->count = res.count();
-                    if (system->queryProcessor && system->count > 0) {
-                        if (system->updatesOnly) {
-                            res.onlyUpdatedAfter(system->lastRunSequence);
+                    if (system->updatesOnly) {
+                        res.onlyUpdatedAfter(system->lastRunSequence);
+                        if (!res.hasUpdates()) {
+                            system->count = 0;
                         }
+                    }
+                    if (system->queryProcessor && system->count > 0) {
                         system->count = system->queryProcessor(res);
                     }
+                    system->lastChangeTick = tick;
+                    ++changeTick;
                     if (system->executeIfNoneProcessor && system->count == 0) {
                         if (system->thread) {
                             return jobInterface->create(
                                 [=, this]()
                                 {
                                     system->executeIfNoneProcessor(this);
-                                    const auto end = std::chrono::high_resolution_clock::now();
+                                    const auto end = std::chrono::steady_clock::now();
                                     system->executionTime = system->executionTime * 0.9f + 0.1f *
                                         std::chrono::duration<
                                             float>(end - system->startTime).count();
@@ -656,7 +910,7 @@ namespace ecs
                             [=, this]()
                             {
                                 system->executeProcessor(this);
-                                const auto end = std::chrono::high_resolution_clock::now();
+                                const auto end = std::chrono::steady_clock::now();
                                 system->executionTime = system->executionTime * 0.9f + 0.1f *
                                     std::chrono::duration<
                                         float>(end - system->startTime).count();
@@ -667,7 +921,7 @@ namespace ecs
                         system->executeProcessor(this);
                     }
                 }
-                const auto end = std::chrono::high_resolution_clock::now();
+                const auto end = std::chrono::steady_clock::now();
                 system->executionTime = system->executionTime * 0.9f + 0.1f * std::chrono::duration<
                     float>(end - system->startTime).count();
             }
@@ -843,12 +1097,35 @@ namespace ecs
             inFlights.pop_front();
         }
         grp->executionSequence = std::move(sequence);
-        //const auto end = std::chrono::high_resolution_clock::now();
+        //const auto end = std::chrono::steady_clock::now();
+    }
+
+    void World::checkChangeTicks()
+    {
+        if (changeTick - lastTickCheck < Column::tickCheckInterval) {
+            return;
+        }
+        lastTickCheck = changeTick;
+
+        for (auto & [archetype, table]: tables) {
+            for (auto & column: table->columns) {
+                column->clampTicks(changeTick);
+            }
+        }
+        getResults(systemQuery).each<System>(
+            [this](EntityHandle, System * system)
+            {
+                if (changeTick - system->lastChangeTick > Column::maxTickAge) {
+                    system->lastChangeTick = changeTick - Column::maxTickAge;
+                }
+            }
+        );
     }
 
     void World::executeSystemGroup(entity_t systemGroup)
     {
         updateSequence++;
+        checkChangeTicks();
 
         auto group_details = getUpdate<SystemGroup>(systemGroup);
         if (group_details->onBegin) {
@@ -879,6 +1156,8 @@ namespace ecs
             auto sp = getUpdate<System>(sid);
             sp->lastRunSequence = updateSequence;
         }
+        /* Writes made between groups are newer than anything the group has seen */
+        updateSequence++;
         deltaTime_ = savedDelta;
         if (group_details->onEnd) {
             group_details->onEnd();
@@ -893,12 +1172,12 @@ namespace ecs
         for (auto pg: pipelineGroupSequence) {
             float runTime;
             auto gd = getUpdate<SystemGroup>(pg);
-            const auto start = std::chrono::high_resolution_clock::now();
+            const auto start = std::chrono::steady_clock::now();
             executeSystemGroup(pg);
-            const auto systems = std::chrono::high_resolution_clock::now();
+            const auto systems = std::chrono::steady_clock::now();
 
             executeDeferred();
-            const auto end = std::chrono::high_resolution_clock::now();
+            const auto end = std::chrono::steady_clock::now();
 
             runTime = std::chrono::duration<float>(end - systems).count();
             gd->deferredTime = gd->deferredTime * 0.9f + 0.1f * runTime;
@@ -908,7 +1187,7 @@ namespace ecs
             gd->lastTime = gd->lastTime * 0.9f + 0.1f * runTime;
         }
 
-        getResults(streamQuery).each<StreamComponent>(
+        getCachedResults(streamQuery).each<StreamComponent>(
             [](EntityHandle, StreamComponent * s)
             {
                 s->ptr->clear();
@@ -918,7 +1197,23 @@ namespace ecs
 
     void World::executeDeferred()
     {
-        for (auto & command: deferredCommands) {
+        for (size_t i = 0; i < deferredCommands.size();) {
+            auto & command = deferredCommands[i];
+            if (command.type == DeferredCommandType::Add || command.type == DeferredCommandType::Remove) {
+                /* A run of the same add or remove can often take whole tables in one move */
+                auto end = i + 1;
+                while (end < deferredCommands.size()
+                       && deferredCommands[end].type == command.type
+                       && deferredCommands[end].component == command.component) {
+                    end++;
+                }
+                if (end - i > 1) {
+                    executeDeferredRun(std::span(deferredCommands).subspan(i, end - i));
+                    i = end;
+                    continue;
+                }
+            }
+
             switch (command.type) {
             case DeferredCommandType::Add:
                 add(command.entity, command.component);
@@ -931,18 +1226,67 @@ namespace ecs
                 break;
             case DeferredCommandType::Set:
                 {
-                    set(command.entity, command.component, command.ptr);
+                    setMoved(command.entity, command.component, command.ptr);
                     auto cd = getComponentDetails(command.component);
-                    cd->componentDestructor(command.ptr, cd->size, 1);
+                    cd->functions->destructor(command.ptr, cd->size, 1);
 
-                    delete[] static_cast<char *>(command.ptr);
+                    allocator->deallocate(command.ptr, cd->size, cd->alignment);
                 }
                 break;
             }
+            i++;
         }
         deferredCommands.clear();
     }
 
+    void World::executeDeferredRun(std::span<const DeferredCommand> run)
+    {
+        const auto type = run.front().type;
+        const auto componentId = run.front().component;
+
+        std::vector<entity_t> ids;
+        ids.reserve(run.size());
+        for (auto & command: run) {
+            if (isAlive(command.entity)) {
+                ids.push_back(command.entity);
+            }
+        }
+        std::ranges::sort(ids);
+        const auto duplicates = std::ranges::unique(ids);
+        ids.erase(duplicates.begin(), duplicates.end());
+        std::ranges::stable_sort(
+            ids, [this](entity_t a, entity_t b) {
+                return getEntityArchetype(a) < getEntityArchetype(b);
+            }
+        );
+
+        for (size_t first = 0; first < ids.size();) {
+            const auto at = getEntityArchetype(ids[first]);
+            auto last = first + 1;
+            while (last < ids.size() && getEntityArchetype(ids[last]) == at) {
+                last++;
+            }
+
+            Table * table = tables[at].get();
+            if (last - first == table->entities.size()) {
+                if (type == DeferredCommandType::Add) {
+                    addToTable(table, componentId);
+                } else {
+                    removeFromTable(table, componentId);
+                }
+            } else {
+                for (auto k = first; k < last; k++) {
+                    if (type == DeferredCommandType::Add) {
+                        add(ids[k], componentId);
+                    } else {
+                        remove(ids[k], componentId);
+                    }
+                }
+            }
+            first = last;
+        }
+    }
+
     std::string World::description(entity_t id)
     {
         const Name * n = get<Name>(id);
@@ -988,25 +1332,52 @@ namespace ecs
         markSystemsDirty();
     }
 
-    uint16_t World::getEntityArchetype(entity_t id) const
+    archetype_id_t World::getEntityArchetype(entity_t id) const
     {
         //assert(isAlive(id));
         auto & ee = entities[index(id)];
         return ee.archetype;
     }
 
-    void World::moveEntity(entity_t id, uint16_t from, const ArchetypeTransition & trans)
+    Table * World::moveEntity(entity_t id, archetype_id_t from, archetype_id_t to, std::unique_ptr<TransitionPlan> & plan)
     {
         // assert(isAlive(id));
         assert(entities[index(id)].archetype == from);
-        entities[index(id)].archetype = trans.to_at;
+        entities[index(id)].archetype = to;
 
-        ensureTableForArchetype(trans.to_at);
+        auto & transition = transitionPlan(from, to, plan);
+        Table::moveEntity(this, transition.fromTable, transition.toTable, id, transition);
+        return transition.toTable;
+    }
 
-        Table::moveEntity(this, tables[from].get(), tables[trans.to_at].get(), id, trans);
+    TransitionPlan & World::transitionPlan(archetype_id_t from, archetype_id_t to, std::unique_ptr<TransitionPlan> & plan)
+    {
+        if (!plan) {
+            ensureTableForArchetype(to);
+            plan = std::make_unique<TransitionPlan>(Table::planMove(tables[from].get(), tables[to].get()));
+        }
+        return *plan;
     }
 
-    void World::addTableToActiveQueries(Table * table, uint16_t aid)
+    std::span<const entity_t> World::moveTable(archetype_id_t from,
+                                               archetype_id_t to,
+                                               std::unique_ptr<TransitionPlan> & plan)
+    {
+        auto & transition = transitionPlan(from, to, plan);
+
+        const auto count = static_cast<uint32_t>(transition.fromTable->entities.size());
+        const auto first = Table::moveEntities(this, transition);
+
+        const std::span<const entity_t> moved(transition.toTable->entities.data() + first, count);
+        for (auto id: moved) {
+            entities[index(id)].archetype = to;
+            entities.updateSequence(index(id)) = updateSequence;
+        }
+        transition.toTable->noteUpdates(first, count, updateSequence);
+        return moved;
+    }
+
+    void World::addTableToActiveQueries(Table * table, archetype_id_t aid)
     {
         auto & ad = am.getArchetypeDetails(aid);
         /* This will only be 0 during world bootstrap, ie when we are adding queryquery */
@@ -1041,13 +1412,13 @@ namespace ecs
         }
     }
 
-    void World::ensureTableForArchetype(uint16_t aid)
+    void World::ensureTableForArchetype(archetype_id_t aid)
     {
         if (tables.find(aid) != tables.end()) {
             return;
         }
 
-        auto t = std::make_unique<Table>(this, aid);
+        auto t = makeAllocated<Table>(allocator, this, aid);
         Table * ptr = t.get();
         tables[aid] = std::move(t);
 
@@ -1107,6 +1478,14 @@ namespace ecs
     std::string World::trimName(const char * n)
     {
         std::string newName = n;
+#if defined(__GNUG__)
+        int status = 0;
+        char * demangled = abi::__cxa_demangle(n, nullptr, nullptr, &status);
+        if (status == 0 && demangled) {
+            newName = demangled;
+        }
+        std::free(demangled);
+#endif
         if (newName.starts_with("struct ")) {
             newName = newName.substr(7);
         }
@@ -1168,12 +1547,14 @@ namespace ecs
         systemOrderDirty = false;
     }
 
-    void World::setEntityUpdateSequence(entity_t id)
+    void World::setEntityUpdateSequence(entity_t id, Table * table)
     {
         assert(isAlive(id));
         //const auto v = version(id);
         const auto i = index(id);
-        entities[i].updateSequence = updateSequence;
+        assert(table == tables[entities[i].archetype].get());
+        entities.updateSequence(i) = updateSequence;
+        table->noteUpdate(entities[i].row, updateSequence);
     }
 
     Filter World::createFilter(std::vector<component_id_t> with,
@@ -1181,25 +1562,18 @@ namespace ecs
     {
         std::vector<TableView> tvs;
 
-        for (auto & at: *this) {
-            std::vector<component_id_t> with_overlap;
-            std::vector<component_id_t> without_overlap;
+        const auto withSignature = am.makeSignature(with);
+        const auto withoutSignature = am.makeSignature(without);
 
-            std::ranges::set_intersection(at.components, with, std::back_inserter(with_overlap));
-
-            if (with_overlap.size() < with.size()) {
+        for (auto & at: *this) {
+            if (!at.signature.containsAll(withSignature) || at.signature.intersects(withoutSignature)) {
                 continue;
             }
 
-            std::ranges::set_intersection(at.components, without,
-                                          std::back_inserter(without_overlap));
-            if (!without_overlap.empty()) {
-                continue;
+            Table * tab = getTableForArchetype(at.id);
+            if (tab) {
+                TableView::appendTableViews(this, tab, tvs);
             }
-
-            Table * tab = tables[at.id].get();
-
-            tvs.push_back({this, tab, tab->lastUpdateTimestamp, 0, tab->entities.size()});
         }
 
         return Filter(this, tvs);
@@ -1224,40 +1598,54 @@ namespace ecs
         }
     }
 
+    void World::postEntities(std::span<const entity_t> ids, std::vector<entity_t> & posts)
+    {
+        for (auto ona: posts) {
+            if (queues.contains(ona)) {
+                queues[ona]->add(ids);
+            }
+        }
+    }
+
+    namespace
+    {
+        void eraseTrigger(std::vector<entity_t> & triggers, entity_t entity)
+        {
+            auto it = std::find(triggers.begin(), triggers.end(), entity);
+            if (it != triggers.end()) {
+                triggers.erase(it);
+            }
+        }
+    }
+
     void World::addRemoveTrigger(component_id_t componentId, entity_t entity)
     {
-        auto cd = getUpdate<Component>(componentId);
-        cd->onRemove.push_back(entity);
+        getUpdate<Component>(componentId)->onRemove.push_back(entity);
+        componentDetails(componentId)->onRemove.push_back(entity);
     }
 
     void World::removeRemoveTrigger(component_id_t componentId, entity_t entity)
     {
-        auto cd = getUpdate<Component>(componentId);
-        auto it = std::find(cd->onRemove.begin(), cd->onRemove.end(), entity);
-        if (it != cd->onRemove.end()) {
-            cd->onRemove.erase(it);
-        }
+        eraseTrigger(getUpdate<Component>(componentId)->onRemove, entity);
+        eraseTrigger(componentDetails(componentId)->onRemove, entity);
     }
 
     void World::addAddTrigger(component_id_t componentId, entity_t entity)
     {
-        auto cd = getUpdate<Component>(componentId);
-        cd->onAdds.push_back(entity);
+        getUpdate<Component>(componentId)->onAdds.push_back(entity);
+        componentDetails(componentId)->onAdds.push_back(entity);
     }
 
     void World::addUpdateTrigger(component_id_t componentId, entity_t entity)
     {
-        auto cd = getUpdate<Component>(componentId);
-        cd->onUpdates.push_back(entity);
+        getUpdate<Component>(componentId)->onUpdates.push_back(entity);
+        componentDetails(componentId)->onUpdates.push_back(entity);
     }
 
     void World::removeAddTrigger(component_id_t componentId, entity_t entity)
     {
-        auto cd = getUpdate<Component>(componentId);
-        auto it = std::find(cd->onAdds.begin(), cd->onAdds.end(), entity);
-        if (it != cd->onAdds.end()) {
-            cd->onAdds.erase(it);
-        }
+        eraseTrigger(getUpdate<Component>(componentId)->onAdds, entity);
+        eraseTrigger(componentDetails(componentId)->onAdds, entity);
     }
 
     EntityQueue * World::getEntityQueue(entity_t id) const
@@ -27,8 +27,10 @@
 #include <deque>
 #include <map>
 #include <mutex>
+#include <optional>
 #include <vector>
 #include <set>
+#include <span>
 #include <stack>
 #include <typeinfo>
 #include <unordered_set>
@@ -38,11 +40,13 @@
 #include "ArchetypeManager.h"
 #include "Component.h"
 #include "Entity.h"
+#include "EntityStore.h"
 #include "EntityHandle.h"
 #include "QueryBuilder.h"
 #include "Table.h"
 #include "SystemBuilder.h"
 #include "EntityQueueHandle.h"
+#include "WorldAllocator.h"
 
 namespace ecs
 {
@@ -59,6 +63,16 @@ namespace ecs
 
         template<typename T>
         const T * const type_id_ptr<T>::id = nullptr;
+
+        /* The id T last resolved to and the world it came from, see World::getComponentId */
+        struct component_slot
+        {
+            uint64_t epoch = 0;
+            uint64_t id = 0;
+        };
+
+        template<typename T>
+        inline thread_local component_slot componentSlot{};
     }
 
     using type_id_t = const void *;
@@ -69,20 +83,18 @@ namespace ecs
         return &type_helper::type_id_ptr<T>::id;
     }
 
+    /* A list of component types to hand to World::registerComponents. Only the type list is
+     * fixed at build time, the ids are still assigned when the world registers them. */
+    template<typename ... Ts>
+    struct ComponentList
+    {
+    };
+
     struct Stream;
     struct Query;
     struct Filter;
     struct EntityQueue;
 
-    struct EntityEntry
-    {
-        uint32_t version;
-        uint32_t row;
-        uint64_t updateSequence;
-        uint16_t archetype;
-        bool alive;
-    };
-
     struct Prefab
     {
     };
@@ -186,13 +198,22 @@ namespace ecs
         friend class ActiveSystem;
 
     public:
-        World();
+        explicit World(WorldAllocator * worldAllocator = nullptr);
         ~World();
 
         EntityHandle newEntity(const char * name = nullptr);
+
+        /* Creates count entities directly in the archetype of the given components. The span
+         * points into the table and is only valid until its next structural change. */
+        template<typename ... Ts>
+        std::span<const entity_t> spawn(uint32_t count);
+        std::span<const entity_t> spawn(std::span<const component_id_t> componentIds, uint32_t count);
         EntityHandle newEntityReplace(const char * name);
         //entity_t newEntity();
         EntityHandle instantiate(entity_t prefab);
+        /* Creates count copies of a prefab in one pass. The span points into the table and is
+         * only valid until its next structural change. */
+        std::span<const entity_t> instantiate(entity_t prefab, uint32_t count);
 
         EntityHandle lookup(const char * name);
         EntityHandle lookup(const std::string & name);
@@ -205,6 +226,11 @@ namespace ecs
         void add(entity_t id);
         void add(entity_t id, component_id_t componentId);
 
+        /* Adds every missing component with a single move into the final archetype */
+        template<typename ... Ts> requires (sizeof...(Ts) > 1)
+        void add(entity_t id);
+        void add(entity_t id, std::span<const component_id_t> componentIds);
+
         template<typename T>
         void addDeferred(entity_t id);
         void addDeferred(entity_t id, component_id_t componentId);
@@ -221,6 +247,16 @@ namespace ecs
         void removeDeferred(entity_t id);
         void removeDeferred(entity_t id, component_id_t componentId);
 
+        /* Bulk destroy/add/remove over everything a query matches. These work a table at a time,
+         * so they must not be called while iterating that query. */
+        void destroyAll(queryid_t q);
+        template<typename T>
+        void addToAll(queryid_t q);
+        void addToAll(queryid_t q, component_id_t componentId);
+        template<typename T>
+        void removeFromAll(queryid_t q);
+        void removeFromAll(queryid_t q, component_id_t componentId);
+
         template<typename T>
         const T * get(entity_t id, bool inherit = false);
         template<class T>
@@ -236,8 +272,19 @@ namespace ecs
 
         template<typename T>
         void set(entity_t id, const T & value);
+
+        template<typename ... Ts> requires (sizeof...(Ts) > 1 && (!std::is_pointer_v<Ts> && ...))
+        void set(entity_t id, const Ts & ... values);
         void set(entity_t id, component_id_t componentId, const void * ptr);
 
+        /* Moves value into place, building a missing component straight from it */
+        template<typename T> requires (!std::is_reference_v<T>)
+        void set(entity_t id, T && value);
+
+        /* Constructs a missing T in its new row from args, or assigns over an existing one */
+        template<typename T, typename ... Args>
+        T * emplace(entity_t id, Args && ... args);
+
         template<typename T>
         void setDeferred(entity_t id, const T & value);
         void setDeferred(entity_t id, component_id_t componentId, void * ptr);
@@ -272,9 +319,28 @@ namespace ecs
 
         const Component * getComponentDetails(component_id_t id);
 
+        template<typename T>
+        uint16_t getColumnAlignment();
+        uint16_t getColumnAlignment(component_id_t id);
+
+        /* Dense component index owned by the archetype manager, see ArchetypeManager::getComponentIndex */
+        static constexpr uint32_t invalidComponentIndex = ArchetypeManager::invalidComponentIndex;
+
+        [[nodiscard]] uint32_t getComponentIndex(component_id_t id) const
+        {
+            return am.getComponentIndex(id);
+        }
+
         template<typename T>
         component_id_t getComponentId();
 
+        /* Runtime warm up: resolves the listed types' ids now, in order, rather than on first
+         * use. Later getComponentId<T> calls still take the thread_local slot and epoch check. */
+        template<typename ... Ts>
+        void registerComponents();
+        template<typename ... Ts>
+        void registerComponents(ComponentList<Ts...>);
+
         QueryBuilder createQuery(const std::set<component_id_t> & with);
 
         template<class ... TArgs>
@@ -288,6 +354,9 @@ namespace ecs
         void deleteQuery(queryid_t q);
         void deleteSystem(systemid_t s);
         QueryResult getResults(queryid_t q);
+        /* The query's own result, refreshed in place. Valid until the query definition changes
+         * and shared by every caller, so it is for dispatch rather than holding on to. */
+        QueryResult & getCachedResults(queryid_t q);
         std::optional<JobInterface::JobHandle> executeSystem(systemid_t sys);
         void executeGroupsSystems(entity_t systemGroup);
         void executeSystemGroup(entity_t systemGroup);
@@ -302,9 +371,15 @@ namespace ecs
             return singletons;
         }
 
-        Table * getTableForArchetype(uint16_t t)
+        [[nodiscard]] WorldAllocator * getAllocator() const
         {
-            return tables[t].get();
+            return allocator;
+        }
+
+        Table * getTableForArchetype(archetype_id_t t)
+        {
+            auto it = tables.find(t);
+            return it == tables.end() ? nullptr : it->second.get();
         }
 
         void executeDeferred();
@@ -371,18 +446,42 @@ namespace ecs
         EntityQueue * getEntityQueue(entity_t id) const;
 
     protected:
-        uint16_t getEntityArchetype(entity_t id) const;
-        void moveEntity(entity_t id, uint16_t from, const ArchetypeTransition & trans);
-        void addTableToActiveQueries(Table * table, uint16_t aid);
+        entity_t allocateEntity(archetype_id_t archetype);
+        archetype_id_t getEntityArchetype(entity_t id) const;
+        /* Returns the entity's new table */
+        Table * moveEntity(entity_t id, archetype_id_t from, archetype_id_t to, std::unique_ptr<TransitionPlan> & plan);
+        TransitionPlan & transitionPlan(archetype_id_t from, archetype_id_t to, std::unique_ptr<TransitionPlan> & plan);
+        /* Adds componentId leaving its new row raw, returns the row or null for a tag. The caller
+         * constructs it before anything else touches the entity. */
+        void * addUnconstructed(entity_t id, component_id_t componentId);
+        void setMoved(entity_t id, component_id_t componentId, void * ptr);
+        /* Bookkeeping after a component value is written: name index, update sequence, triggers */
+        void componentWritten(entity_t id, component_id_t componentId, const void * ptr);
+        /* Stamps the entity's row of componentId with the current change tick */
+        void markChanged(entity_t id, component_id_t componentId);
+        /* Clamps column and system ticks that are about to wrap, every Column::tickCheckInterval */
+        void checkChangeTicks();
+        /* Moves a whole table, returns the moved entities in their new table */
+        std::span<const entity_t> moveTable(archetype_id_t from, archetype_id_t to, std::unique_ptr<TransitionPlan> & plan);
+        void releaseEntity(entity_t id);
+        void addToTable(Table * table, component_id_t componentId);
+        void removeFromTable(Table * table, component_id_t componentId);
+        void executeDeferredRun(std::span<const DeferredCommand> run);
+        void addTableToActiveQueries(Table * table, archetype_id_t aid);
         void removeTableFromActiveQueries(Table * table);
-        void ensureTableForArchetype(uint16_t);
+        void ensureTableForArchetype(archetype_id_t);
 
         void recalculateSystemOrder();
         void recalculateGroupSystemOrder(entity_t group, std::vector<systemid_t> systems);
 
         static std::string trimName(const char * n);
 
-        void setEntityUpdateSequence(entity_t id);
+        /* table is the entity's current table, which callers already hold */
+        void setEntityUpdateSequence(entity_t id, Table * table);
+
+        /* Registry entry of a registered component, valid until the next registration */
+        Component * componentDetails(component_id_t componentId);
+        void registerComponentDetails(component_id_t componentId, const Component & details);
 
         component_id_t createDynamicComponent(entity_t entityId);
         void removeDynamicComponent(entity_t entityId);
@@ -392,6 +491,7 @@ namespace ecs
         void * getUpdate(entity_t id, component_id_t componentId);
 
         void postEntity(entity_t id, std::vector<entity_t> & posts);
+        void postEntities(std::span<const entity_t> ids, std::vector<entity_t> & posts);
 
     public:
         [[nodiscard]] std::vector<entity_t> getPipelineGroupSequence() const
@@ -399,16 +499,45 @@ namespace ecs
             return pipelineGroupSequence;
         }
 
+        /* Stamped into Column row ticks, and advanced around every query system run */
+        [[nodiscard]] tick_t getChangeTick() const
+        {
+            return changeTick;
+        }
+
+        /* Counts the changed<> terms on a component. Writes only stamp changed ticks while a
+         * query has one, so rows written before the term was added read as unchanged. */
+        void trackChanges(component_id_t componentId);
+        void untrackChanges(component_id_t componentId);
+
+        [[nodiscard]] bool tracksChanges(component_id_t componentId) const
+        {
+            const auto componentIndex = getComponentIndex(componentId);
+            return componentIndex < changeTrackers.size() && changeTrackers[componentIndex] > 0;
+        }
+
     private:
-        std::vector<EntityEntry> entities{};
+        std::unique_ptr<PoolAllocator> defaultAllocator;
+        WorldAllocator * allocator;
+
+        /* Unique per world instance, so per type slots cached for another world are ignored */
+        const uint64_t epoch;
+
+        EntityStore entities{};
 
-        size_t recycleStart;
+        /* Dead slots form a stack threaded through EntityEntry::row */
+        static constexpr uint32_t noFreeEntity = std::numeric_limits<uint32_t>::max();
+        uint32_t freeEntity = noFreeEntity;
         robin_hood::unordered_flat_map<type_id_t, component_id_t> componentMap{};
 
         Component componentBootstrap;
         component_id_t componentBootstrapId;
 
-        robin_hood::unordered_flat_map<uint16_t, std::unique_ptr<Table>> tables;
+        /* Component metadata indexed by dense component index, mirrored from each component
+         * entity's Component when it is set. Trigger lists are written through to both. */
+        std::vector<Component> componentRegistry{};
+
+        robin_hood::unordered_flat_map<archetype_id_t, AllocatorPtr<Table>> tables;
         //robin_hood::unordered_map<component_id_t> streams;
 
         std::unordered_map<entity_t, std::unique_ptr<EntityQueue> > queues;
@@ -438,6 +567,10 @@ namespace ecs
         std::stack<entity_t> moduleScope;
 
         uint64_t updateSequence = 1;
+        tick_t changeTick = 1;
+        tick_t lastTickCheck = 1;
+        /* changed<> terms per dense component index */
+        std::vector<uint32_t> changeTrackers;
 
     public:
         ArchetypeManager am;
@@ -450,6 +583,20 @@ namespace ecs
         add(id, componentId);
     }
 
+    template<typename ... Ts>
+    std::span<const entity_t> World::spawn(uint32_t count)
+    {
+        const std::array<component_id_t, sizeof...(Ts)> componentIds = {getComponentId<Ts>()...};
+        return spawn(componentIds, count);
+    }
+
+    template<typename ... Ts> requires (sizeof...(Ts) > 1)
+    void World::add(entity_t id)
+    {
+        const std::array<component_id_t, sizeof...(Ts)> componentIds = {getComponentId<Ts>()...};
+        add(id, componentIds);
+    }
+
     template<typename T>
     void World::addDeferred(entity_t id)
     {
@@ -474,6 +621,18 @@ namespace ecs
         removeDeferred(id, getComponentId<T>());
     }
 
+    template<typename T>
+    void World::addToAll(queryid_t q)
+    {
+        addToAll(q, getComponentId<T>());
+    }
+
+    template<typename T>
+    void World::removeFromAll(queryid_t q)
+    {
+        removeFromAll(q, getComponentId<T>());
+    }
+
     template<typename T>
     const T * World::get(entity_t id, bool inherit)
     {
@@ -518,16 +677,59 @@ namespace ecs
         set(id, getComponentId<T>(), &value);
     }
 
+    template<typename T> requires (!std::is_reference_v<T>)
+    void World::set(entity_t id, T && value)
+    {
+        emplace<T>(id, std::move(value));
+    }
+
+    template<typename T, typename ... Args>
+    T * World::emplace(entity_t id, Args && ... args)
+    {
+        const auto componentId = getComponentId<T>();
+
+        T * ptr;
+        if (has(id, componentId)) {
+            ptr = static_cast<T *>(getUpdate(id, componentId));
+            if constexpr (sizeof...(Args) == 1 && (std::is_same_v<std::remove_cvref_t<Args>, T> && ...)) {
+                *ptr = (std::forward<Args>(args), ...);
+            } else if constexpr (!std::is_empty_v<T>) {
+                *ptr = T(std::forward<Args>(args)...);
+            }
+        } else if constexpr (std::is_empty_v<T>) {
+            addUnconstructed(id, componentId);
+            ptr = static_cast<T *>(Table::tagPlaceholder());
+        } else {
+            ptr = static_cast<T *>(addUnconstructed(id, componentId));
+            try {
+                std::construct_at(ptr, std::forward<Args>(args)...);
+            } catch (...) {
+                /* Leave the row live so the table stays consistent */
+                std::construct_at(ptr);
+                throw;
+            }
+        }
+
+        componentWritten(id, componentId, ptr);
+        return ptr;
+    }
+
+    template<typename ... Ts> requires (sizeof...(Ts) > 1 && (!std::is_pointer_v<Ts> && ...))
+    void World::set(entity_t id, const Ts & ... values)
+    {
+        add<Ts...>(id);
+        (set(id, getComponentId<Ts>(), &values), ...);
+    }
+
     template<typename T>
     void World::setDeferred(entity_t id, const T & value)
     {
         auto c = getComponentId<T>();
 
-        auto cd = getComponentDetails(c);
-        char * cp = new char[cd->size];
+        void * cp = allocator->allocate(sizeof(T), alignof(T));
 
         T * p = new(cp) T(value);
-        setDeferred(id, getComponentId<T>(), p);
+        setDeferred(id, c, p);
     }
 
     template<typename T>
@@ -572,6 +774,12 @@ namespace ecs
         return getStream(getComponentId<T>());
     }
 
+    template<typename T>
+    uint16_t World::getColumnAlignment()
+    {
+        return getColumnAlignment(getComponentId<T>());
+    }
+
     template<typename T>
     component_id_t World::getComponentId()
     {
@@ -590,36 +798,45 @@ namespace ecs
         );
         // static_assert(std::is_standard_layout<T>(), "Cannot be a component");
 
-        constexpr bool is_relation = std::is_base_of<Relation, std::remove_reference_t<T>>();
+        auto & slot = type_helper::componentSlot<std::remove_reference_t<T>>;
+        if (slot.epoch == epoch) {
+            return slot.id;
+        }
 
         auto v = type_id<std::remove_reference_t<T>>();
 
         auto it = componentMap.find(v);
         if (it != componentMap.end()) {
+            slot = {epoch, it->second};
             return it->second;
         }
 
         component_id_t id = newEntity().id;
         set<Component>(
-            id, {
-                World::trimName(typeid(std::remove_reference_t<T>).name()),
-                sizeof(std::remove_reference_t<T>), alignof(std::remove_reference_t<T>),
-                componentConstructor<std::remove_reference_t<T>>,
-                componentDestructor<std::remove_reference_t<T>>,
-                componentCopy<std::remove_reference_t<T>>,
-                componentMove<std::remove_reference_t<T>>,
-                is_relation,
-                componentAllocator<std::remove_reference_t<T>>,
-                componentDeallocator<std::remove_reference_t<T>>
-            }
+            id, describeComponent<std::remove_reference_t<T>>(
+                World::trimName(typeid(std::remove_reference_t<T>).name())
+            )
         );
 
         componentMap.emplace(v, id);
+        slot = {epoch, id};
         if (id > 2)
             set<Name>(id, {.name = trimName(typeid(std::remove_reference_t<T>).name())});
         return id;
     }
 
+    template<typename ... Ts>
+    void World::registerComponents()
+    {
+        (getComponentId<Ts>(), ...);
+    }
+
+    template<typename ... Ts>
+    void World::registerComponents(ComponentList<Ts...>)
+    {
+        registerComponents<Ts...>();
+    }
+
     template<class ... TArgs>
     QueryBuilder World::createQuery()
     {
@@ -741,8 +958,9 @@ namespace ecs
         }
         f(v);
 
-        auto cd = getUpdate<Component>(getComponentId<T>());
-        postEntity(id, cd->onUpdates);
+        const auto componentId = getComponentId<T>();
+        markChanged(id, componentId);
+        postEntity(id, componentDetails(componentId)->onUpdates);
     }
 
     template<class T>
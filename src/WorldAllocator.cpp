@@ -0,0 +1,113 @@
+////////////////////////////////////////////////////////////////////////////////
+// MIT License
+//
+// Copyright (c) 2021.  Shane Hyde (shane@noctonyx.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+#include "WorldAllocator.h"
+
+namespace ecs
+{
+    PoolAllocator::~PoolAllocator()
+    {
+        for (size_t i = 0; i < classCount; i++) {
+            for (auto & [slab, size]: classes[i].slabs) {
+                ::operator delete(slab, size, std::align_val_t{slabAlignment});
+            }
+        }
+    }
+
+    size_t PoolAllocator::classIndex(const size_t size, const size_t alignment)
+    {
+        const size_t block = std::bit_ceil(std::max({size, alignment, minBlockSize}));
+        if (block > maxBlockSize || alignment > slabAlignment) {
+            return classCount;
+        }
+        return std::countr_zero(block) - std::countr_zero(minBlockSize);
+    }
+
+    void * PoolAllocator::allocate(const size_t size, const size_t alignment)
+    {
+        const auto ix = classIndex(size, alignment);
+        if (ix == classCount) {
+            return ::operator new(size, std::align_val_t{alignment});
+        }
+
+        auto & sc = classes[ix];
+        const size_t block = minBlockSize << ix;
+
+        std::lock_guard guard(sc.mutex);
+
+        if (sc.freeList) {
+            auto b = sc.freeList;
+            sc.freeList = b->next;
+            return b;
+        }
+
+        if (sc.cursor == sc.limit) {
+            const size_t slab_size = std::clamp(block * blocksPerSlab, minSlabSize, maxSlabSize);
+            auto slab = static_cast<std::byte *>(::operator new(slab_size, std::align_val_t{slabAlignment}));
+            sc.slabs.emplace_back(slab, slab_size);
+            sc.cursor = slab;
+            sc.limit = slab + slab_size;
+        }
+
+        void * ptr = sc.cursor;
+        sc.cursor += block;
+        return ptr;
+    }
+
+    void PoolAllocator::deallocate(void * ptr, const size_t size, const size_t alignment)
+    {
+        if (!ptr) {
+            return;
+        }
+        const auto ix = classIndex(size, alignment);
+        if (ix == classCount) {
+            ::operator delete(ptr, size, std::align_val_t{alignment});
+            return;
+        }
+
+        auto & sc = classes[ix];
+        std::lock_guard guard(sc.mutex);
+
+        auto b = static_cast<FreeBlock *>(ptr);
+        b->next = sc.freeList;
+        sc.freeList = b;
+    }
+
+    size_t PoolAllocator::slabBytes() const
+    {
+        size_t total = 0;
+        for (auto & sc: classes) {
+            std::lock_guard guard(sc.mutex);
+            for (auto & [slab, size]: sc.slabs) {
+                total += size;
+            }
+        }
+        return total;
+    }
+}
@@ -0,0 +1,121 @@
+////////////////////////////////////////////////////////////////////////////////
+// MIT License
+//
+// Copyright (c) 2021.  Shane Hyde (shane@noctonyx.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace ecs
+{
+    /* All column pages, tables, singletons and deferred payloads of a World come from here */
+    struct WorldAllocator
+    {
+        virtual ~WorldAllocator() = default;
+
+        virtual void * allocate(size_t size, size_t alignment) = 0;
+        virtual void deallocate(void * ptr, size_t size, size_t alignment) = 0;
+    };
+
+    /* Default allocator. Requests are rounded up to a power of 2 size class and carved out of
+     * large slabs, freed blocks go onto a per class free list for reuse. Slabs are only released
+     * when the allocator is destroyed. Requests bigger than the largest class go to the heap. */
+    class PoolAllocator : public WorldAllocator
+    {
+    public:
+        static constexpr size_t minBlockSize = 64;
+        static constexpr size_t maxBlockSize = 256 * 1024;
+        static constexpr size_t minSlabSize = 64 * 1024;
+        static constexpr size_t maxSlabSize = 1024 * 1024;
+        static constexpr size_t blocksPerSlab = 64;
+        static constexpr size_t slabAlignment = 4096;
+
+        PoolAllocator() = default;
+        ~PoolAllocator() override;
+
+        PoolAllocator(const PoolAllocator &) = delete;
+        PoolAllocator & operator=(const PoolAllocator &) = delete;
+
+        void * allocate(size_t size, size_t alignment) override;
+        void deallocate(void * ptr, size_t size, size_t alignment) override;
+
+        [[nodiscard]] size_t slabBytes() const;
+
+    private:
+        struct FreeBlock
+        {
+            FreeBlock * next;
+        };
+
+        struct SizeClass
+        {
+            mutable std::mutex mutex;
+            FreeBlock * freeList = nullptr;
+            std::byte * cursor = nullptr;
+            std::byte * limit = nullptr;
+            std::vector<std::pair<std::byte *, size_t>> slabs;
+        };
+
+        static constexpr size_t classCount = std::countr_zero(maxBlockSize) - std::countr_zero(minBlockSize) + 1;
+
+        static size_t classIndex(size_t size, size_t alignment);
+
+        std::array<SizeClass, classCount> classes{};
+    };
+
+    template<class T>
+    struct AllocatorDeleter
+    {
+        WorldAllocator * allocator = nullptr;
+
+        void operator()(T * ptr) const
+        {
+            std::destroy_at(ptr);
+            allocator->deallocate(ptr, sizeof(T), alignof(T));
+        }
+    };
+
+    template<class T>
+    using AllocatorPtr = std::unique_ptr<T, AllocatorDeleter<T>>;
+
+    template<class T, class ... Args>
+    AllocatorPtr<T> makeAllocated(WorldAllocator * allocator, Args && ... args)
+    {
+        void * ptr = allocator->allocate(sizeof(T), alignof(T));
+        try {
+            return AllocatorPtr<T>(new(ptr) T(std::forward<Args>(args)...), AllocatorDeleter<T>{allocator});
+        } catch (...) {
+            allocator->deallocate(ptr, sizeof(T), alignof(T));
+            throw;
+        }
+    }
+}
@@ -0,0 +1,313 @@
+////////////////////////////////////////////////////////////////////////////////
+// MIT License
+//
+// Copyright (c) 2021.  Shane Hyde (shane@noctonyx.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+#include "doctest.h"
+#include "RxECS.h"
+#include "TestComponents.h"
+
+/* Global replacements so tests can count heap allocations made by the library. Counting is off
+ * unless a test turns it on. */
+namespace
+{
+    std::atomic<bool> countAllocations{false};
+    std::atomic<uint64_t> allocationCount{0};
+
+    void * countedAllocate(std::size_t size)
+    {
+        if (countAllocations) {
+            allocationCount++;
+        }
+        if (void * p = std::malloc(size ? size : 1)) {
+            return p;
+        }
+        throw std::bad_alloc();
+    }
+
+    void * countedAllocateAligned(std::size_t size, std::align_val_t alignment)
+    {
+        if (countAllocations) {
+            allocationCount++;
+        }
+        const auto align = static_cast<std::size_t>(alignment);
+#ifdef _MSC_VER
+        /* The MSVC CRT has no aligned_alloc, and its aligned blocks must go back to _aligned_free */
+        if (void * p = _aligned_malloc(size ? size : 1, align)) {
+            return p;
+        }
+#else
+        /* aligned_alloc wants the size to be a multiple of the alignment */
+        const auto rounded = ((size ? size : 1) + align - 1) / align * align;
+        if (void * p = std::aligned_alloc(align, rounded)) {
+            return p;
+        }
+#endif
+        throw std::bad_alloc();
+    }
+
+    void freeAligned(void * ptr)
+    {
+#ifdef _MSC_VER
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+
+    struct AllocationCounter
+    {
+        AllocationCounter()
+        {
+            allocationCount = 0;
+            countAllocations = true;
+        }
+
+        ~AllocationCounter()
+        {
+            countAllocations = false;
+        }
+
+        [[nodiscard]] uint64_t count() const
+        {
+            return allocationCount;
+        }
+    };
+}
+
+void * operator new(std::size_t size)
+{
+    return countedAllocate(size);
+}
+
+void * operator new[](std::size_t size)
+{
+    return countedAllocate(size);
+}
+
+void * operator new(std::size_t size, std::align_val_t alignment)
+{
+    return countedAllocateAligned(size, alignment);
+}
+
+void * operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return countedAllocateAligned(size, alignment);
+}
+
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    try {
+        return countedAllocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void * operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    try {
+        return countedAllocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void * operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    try {
+        return countedAllocateAligned(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void * operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    try {
+        return countedAllocateAligned(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void * ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void * ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void * ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void * ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void * ptr, std::align_val_t) noexcept
+{
+    freeAligned(ptr);
+}
+
+void operator delete[](void * ptr, std::align_val_t) noexcept
+{
+    freeAligned(ptr);
+}
+
+void operator delete(void * ptr, std::size_t, std::align_val_t) noexcept
+{
+    freeAligned(ptr);
+}
+
+void operator delete[](void * ptr, std::size_t, std::align_val_t) noexcept
+{
+    freeAligned(ptr);
+}
+
+void operator delete(void * ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void * ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void * ptr, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    freeAligned(ptr);
+}
+
+void operator delete[](void * ptr, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    freeAligned(ptr);
+}
+
+TEST_SUITE("Allocations")
+{
+    TEST_CASE("Pool slabs and large blocks are counted")
+    {
+        ecs::World w;
+        auto * allocator = w.getAllocator();
+
+        uint64_t allocations;
+        {
+            AllocationCounter counter;
+            void * large = allocator->allocate(1 << 20, 64);
+            allocator->deallocate(large, 1 << 20, 64);
+            allocations = counter.count();
+        }
+        CHECK(allocations == 1);
+    }
+
+    TEST_CASE("Structural changes don't allocate in steady state")
+    {
+        ecs::World w;
+
+        std::vector<ecs::EntityHandle> entities;
+        for (int i = 0; i < 100; i++) {
+            entities.push_back(w.newEntity().add<TestComponent>());
+        }
+
+        auto toggle = [&]() {
+            for (auto & e: entities) {
+                e.add<TestTag>();
+                e.add<TestComponent2>();
+            }
+            for (auto & e: entities) {
+                e.remove<TestTag>();
+                e.remove<TestComponent2>();
+            }
+        };
+
+        /* First pass builds the archetypes, tables, edges and plans */
+        toggle();
+
+        uint64_t allocations;
+        {
+            AllocationCounter counter;
+            for (int i = 0; i < 10; i++) {
+                toggle();
+            }
+            allocations = counter.count();
+        }
+        CHECK(allocations == 0);
+        CHECK(entities[0].has<TestComponent>());
+        CHECK(!entities[0].has<TestTag>());
+    }
+
+    TEST_CASE("Query system dispatch doesn't allocate in steady state")
+    {
+        ecs::World w;
+        w.newEntity("Group:1").set<ecs::SystemGroup>({1, false, 0.f, 0.f});
+
+        for (int i = 0; i < 100; i++) {
+            w.newEntity().set<TestComponent>({1});
+        }
+        w.newEntity().set<TestComponent>({1}).add<TestTag>();
+
+        uint32_t sum = 0;
+        auto system = w.createSystem("Sum").withQuery<TestComponent>()
+                       .inGroup("Group:1")
+                       .each<TestComponent>([&sum](ecs::EntityHandle, TestComponent * t)
+                       {
+                           sum += t->x;
+                       });
+
+        /* First run builds the query's cached result */
+        w.executeSystem(system.id);
+
+        uint64_t allocations;
+        {
+            AllocationCounter counter;
+            for (int i = 0; i < 10; i++) {
+                w.executeSystem(system.id);
+            }
+            allocations = counter.count();
+        }
+        CHECK(allocations == 0);
+        CHECK(sum == 11 * 101);
+
+        /* New rows and new tables are picked up by the cached result */
+        w.newEntity().set<TestComponent>({10});
+        w.newEntity().set<TestComponent>({100}).set<TestComponent3>({0});
+        sum = 0;
+        w.executeSystem(system.id);
+        CHECK(sum == 101 + 10 + 100);
+    }
+}
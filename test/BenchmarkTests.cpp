@@ -0,0 +1,547 @@
+////////////////////////////////////////////////////////////////////////////////
+// MIT License
+//
+// Copyright (c) 2021.  Shane Hyde (shane@noctonyx.com)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+#include "doctest.h"
+#include "RxECS.h"
+#include "TestComponents.h"
+
+/* Benchmarks are skipped by default, run with RxECS_tests -ts=Benchmarks --no-skip */
+TEST_SUITE("Benchmarks" * doctest::skip())
+{
+    using BenchClock = std::chrono::steady_clock;
+
+    struct Transform
+    {
+        float position[4];
+        float rotation[4];
+        float scale[4];
+        float padding[4];
+    };
+
+    template<int N>
+    struct WideField
+    {
+        float value[4];
+    };
+
+    template<int ... N>
+    void addWideFields(ecs::EntityHandle e, std::integer_sequence<int, N...>)
+    {
+        (e.add<WideField<N>>(), ...);
+    }
+
+    template<int ... N>
+    std::vector<ecs::component_id_t> wideFieldIds(ecs::World & w, std::integer_sequence<int, N...>)
+    {
+        return {w.getComponentId<WideField<N>>()...};
+    }
+
+    template<int N>
+    struct BenchTag
+    {
+    };
+
+    template<int ... N>
+    void addBenchTags(ecs::EntityHandle e, uint32_t mask, std::integer_sequence<int, N...>)
+    {
+        ((mask & (1u << N) ? (void) e.add<BenchTag<N>>() : (void) 0), ...);
+    }
+
+    TEST_CASE("Worst case column append latency")
+    {
+        ecs::World w;
+        ecs::Column column(w.getComponentId<Transform>(), &w);
+
+        const uint32_t total = 200000;
+        const uint32_t bucket = 20000;
+
+        double worst = 0.0;
+        for (uint32_t i = 0; i < total; i++) {
+            const auto start = BenchClock::now();
+            column.addEntry();
+            const auto end = BenchClock::now();
+            worst = std::max(worst, std::chrono::duration<double, std::micro>(end - start).count());
+
+            if ((i + 1) % bucket == 0) {
+                MESSAGE("rows ", i + 1, ": worst Column::addEntry ", worst, "us");
+                worst = 0.0;
+            }
+        }
+    }
+
+    TEST_CASE("Worst case insert latency")
+    {
+        ecs::World w;
+
+        const uint32_t total = 200000;
+        const uint32_t bucket = 20000;
+
+        double worst = 0.0;
+        for (uint32_t i = 0; i < total; i++) {
+            auto e = w.newEntity();
+            const auto start = BenchClock::now();
+            e.add<Transform>();
+            const auto end = BenchClock::now();
+            worst = std::max(worst, std::chrono::duration<double, std::micro>(end - start).count());
+
+            if ((i + 1) % bucket == 0) {
+                MESSAGE("rows ", i + 1, ": worst add<Transform> ", worst, "us");
+                worst = 0.0;
+            }
+        }
+    }
+
+    TEST_CASE("Wide archetype column lookup")
+    {
+        ecs::World w;
+        using Fields = std::make_integer_sequence<int, 24>;
+
+        std::vector<ecs::entity_t> ids;
+        for (uint32_t i = 0; i < 10000; i++) {
+            auto e = w.newEntity();
+            addWideFields(e, Fields{});
+            ids.push_back(e.id);
+        }
+
+        const auto fields = wideFieldIds(w, Fields{});
+        const uint32_t rounds = 50;
+        uintptr_t check = 0;
+        auto start = BenchClock::now();
+        for (uint32_t r = 0; r < rounds; r++) {
+            for (auto id: ids) {
+                for (auto f: fields) {
+                    check += reinterpret_cast<uintptr_t>(w.get(id, f));
+                }
+            }
+        }
+        auto end = BenchClock::now();
+        const double gets = double(rounds) * double(ids.size()) * double(fields.size());
+        MESSAGE("get on 24 column archetype: ",
+                std::chrono::duration<double, std::nano>(end - start).count() / gets, "ns per get ", check);
+
+        auto q = w.createQuery<WideField<0>, WideField<12>, WideField<23>>().id;
+        auto res = w.getResults(q);
+        const std::array<ecs::component_id_t, 3> comps = {fields[0], fields[12], fields[23]};
+        const uint32_t setups = 1000000;
+        start = BenchClock::now();
+        for (uint32_t r = 0; r < setups; r++) {
+            for (auto & view: res) {
+                auto columns = view.getColumns<WideField<0>, WideField<12>, WideField<23>>(comps);
+                check += reinterpret_cast<uintptr_t>(columns[2]);
+            }
+        }
+        end = BenchClock::now();
+        MESSAGE("query column setup: ",
+                std::chrono::duration<double, std::nano>(end - start).count() / (double(setups) * res.size()),
+                "ns per view getColumns ", check);
+    }
+
+    TEST_CASE("Query registration over many archetypes")
+    {
+        ecs::World w;
+
+        /* Every subset of 12 tags, plus the intermediate archetypes on the way */
+        for (uint32_t mask = 0; mask < 4096; mask++) {
+            addBenchTags(w.newEntity(), mask, std::make_integer_sequence<int, 12>{});
+        }
+        const auto archetypes = w.am.archetypes.size();
+
+        auto q = w.createQuery<BenchTag<3>, BenchTag<7>>().without<BenchTag<11>>().id;
+
+        const uint32_t rounds = 200;
+        size_t matched = 0;
+        const auto start = BenchClock::now();
+        for (uint32_t r = 0; r < rounds; r++) {
+            w.update<ecs::Query>(q, [&](ecs::Query * qp) {
+                qp->recalculateQuery(&w);
+                matched = qp->tables.size();
+            });
+        }
+        const auto end = BenchClock::now();
+        MESSAGE("recalculateQuery over ", archetypes, " archetypes (", matched, " matched): ",
+                std::chrono::duration<double, std::micro>(end - start).count() / rounds, "us");
+    }
+
+    TEST_CASE("Tag toggle on hot entities")
+    {
+        ecs::World w;
+
+        std::vector<ecs::EntityHandle> hot;
+        for (uint32_t i = 0; i < 1000; i++) {
+            hot.push_back(w.newEntity().add<Transform>());
+        }
+
+        const uint32_t rounds = 200;
+        const auto start = BenchClock::now();
+        for (uint32_t r = 0; r < rounds; r++) {
+            for (auto & e: hot) {
+                e.add<BenchTag<0>>();
+            }
+            for (auto & e: hot) {
+                e.remove<BenchTag<0>>();
+            }
+        }
+        const auto end = BenchClock::now();
+        MESSAGE("add/remove tag: ",
+                std::chrono::duration<double, std::nano>(end - start).count() / (2.0 * rounds * hot.size()),
+                "ns per structural change");
+    }
+
+    TEST_CASE("Spawn versus newEntity")
+    {
+        const uint32_t count = 50000;
+        {
+            ecs::World w;
+            const auto start = BenchClock::now();
+            for (uint32_t i = 0; i < count; i++) {
+                w.newEntity().add<Transform, WideField<0>, BenchTag<0>>();
+            }
+            const auto end = BenchClock::now();
+            MESSAGE("newEntity().add<...> x", count, ": ", std::chrono::duration<double, std::milli>(end - start).count(), "ms");
+        }
+        {
+            ecs::World w;
+            const auto start = BenchClock::now();
+            auto ids = w.spawn<Transform, WideField<0>, BenchTag<0>>(count);
+            const auto end = BenchClock::now();
+            MESSAGE("spawn<...>(", ids.size(), "): ", std::chrono::duration<double, std::milli>(end - start).count(), "ms");
+        }
+    }
+
+    TEST_CASE("Instantiate prefabs in bulk")
+    {
+        const uint32_t count = 50000;
+        auto makePrefab = [](ecs::World & w) {
+            auto prefab = w.newEntity("bench prefab");
+            prefab.set<Transform>({});
+            prefab.add<WideField<0>, BenchTag<0>, ecs::Prefab>();
+            return prefab.id;
+        };
+        {
+            ecs::World w;
+            const auto prefab = makePrefab(w);
+            const auto start = BenchClock::now();
+            for (uint32_t i = 0; i < count; i++) {
+                w.instantiate(prefab);
+            }
+            const auto end = BenchClock::now();
+            MESSAGE("instantiate(prefab) x", count, ": ", std::chrono::duration<double, std::milli>(end - start).count(), "ms");
+        }
+        {
+            ecs::World w;
+            const auto prefab = makePrefab(w);
+            const auto start = BenchClock::now();
+            auto ids = w.instantiate(prefab, count);
+            const auto end = BenchClock::now();
+            MESSAGE("instantiate(prefab, ", ids.size(), "): ", std::chrono::duration<double, std::milli>(end - start).count(), "ms");
+        }
+    }
+
+    TEST_CASE("Bulk changes over a query")
+    {
+        const uint32_t count = 100000;
+        {
+            ecs::World w;
+            auto ids = w.spawn<Transform, WideField<0>>(count);
+            std::vector<ecs::entity_t> all(ids.begin(), ids.end());
+            const auto start = BenchClock::now();
+            for (auto id: all) {
+                w.add<BenchTag<0>>(id);
+            }
+            for (auto id: all) {
+                w.destroy(id);
+            }
+            const auto end = BenchClock::now();
+            MESSAGE("add + destroy per entity x", count, ": ", std::chrono::duration<double, std::milli>(end - start).count(), "ms");
+        }
+        {
+            ecs::World w;
+            w.spawn<Transform, WideField<0>>(count);
+            auto q = w.createQuery<Transform>().id;
+            const auto start = BenchClock::now();
+            w.addToAll<BenchTag<0>>(q);
+            w.destroyAll(q);
+            const auto end = BenchClock::now();
+            MESSAGE("addToAll + destroyAll x", count, ": ", std::chrono::duration<double, std::milli>(end - start).count(), "ms");
+        }
+    }
+
+    TEST_CASE("Whole table relabelling")
+    {
+        const uint32_t count = 100000;
+        ecs::World w;
+        auto ids = w.spawn<Transform, WideField<0>, WideField<1>>(count);
+        std::vector<ecs::entity_t> all(ids.begin(), ids.end());
+        auto q = w.createQuery<Transform>().id;
+
+        for (int round = 0; round < 2; round++) {
+            auto start = BenchClock::now();
+            for (auto id: all) {
+                w.addDeferred<BenchTag<0>>(id);
+            }
+            w.executeDeferred();
+            auto end = BenchClock::now();
+            MESSAGE("deferred add to whole table x", count, ": ", std::chrono::duration<double, std::milli>(end - start).count(), "ms");
+
+            start = BenchClock::now();
+            w.removeFromAll<BenchTag<0>>(q);
+            end = BenchClock::now();
+            MESSAGE("removeFromAll x", count, ": ", std::chrono::duration<double, std::milli>(end - start).count(), "ms");
+        }
+    }
+
+    TEST_CASE("Entity churn")
+    {
+        const uint32_t count = 1000000;
+        ecs::World w;
+        auto ids = w.spawn<Transform>(count);
+        std::vector<ecs::entity_t> live(ids.begin(), ids.end());
+
+        std::mt19937 rng(1234);
+        for (int round = 0; round < 3; round++) {
+            std::shuffle(live.begin(), live.end(), rng);
+            const auto churn = live.size() / 10;
+
+            const auto start = BenchClock::now();
+            for (size_t i = 0; i < churn; i++) {
+                w.destroy(live[i]);
+            }
+            for (size_t i = 0; i < churn; i++) {
+                live[i] = w.newEntity().add<Transform>().id;
+            }
+            const auto end = BenchClock::now();
+            MESSAGE("destroy + respawn ", churn, " of ", count, ": ", std::chrono::duration<double, std::milli>(end - start).count(), "ms");
+        }
+
+        /* Destroying and respawning one at a time is what scanning for a free slot handled worst */
+        std::uniform_int_distribution<size_t> pick(0, live.size() - 1);
+        const auto start = BenchClock::now();
+        for (size_t i = 0; i < live.size() / 10; i++) {
+            auto & slot = live[pick(rng)];
+            w.destroy(slot);
+            slot = w.newEntity().add<Transform>().id;
+        }
+        const auto end = BenchClock::now();
+        MESSAGE("interleaved destroy/respawn ", live.size() / 10, " of ", count, ": ", std::chrono::duration<double, std::milli>(end - start).count(), "ms");
+    }
+
+    TEST_CASE("Typed component access")
+    {
+        const uint32_t count = 100000;
+        ecs::World w;
+        auto ids = w.spawn<Transform, WideField<0>, WideField<1>>(count);
+        std::vector<ecs::entity_t> all(ids.begin(), ids.end());
+
+        float sum = 0.f;
+        const auto start = BenchClock::now();
+        for (int round = 0; round < 10; round++) {
+            for (auto id: all) {
+                if (w.has<WideField<1>>(id)) {
+                    sum += w.get<WideField<0>>(id)->value[0] + w.get<Transform>(id)->scale[0];
+                }
+            }
+        }
+        const auto end = BenchClock::now();
+        MESSAGE("has + 2 get per entity: ", std::chrono::duration<double, std::nano>(end - start).count() / (10.0 * count), "ns (", sum, ")");
+
+        const Transform value{};
+        const auto setStart = BenchClock::now();
+        for (int round = 0; round < 10; round++) {
+            for (auto id: all) {
+                w.set<Transform>(id, value);
+            }
+        }
+        const auto setEnd = BenchClock::now();
+        MESSAGE("set per entity: ", std::chrono::duration<double, std::nano>(setEnd - setStart).count() / (10.0 * count), "ns");
+    }
+
+    TEST_CASE("Transitions with many archetypes")
+    {
+        for (int bits: {10, 14, 17}) {
+            ecs::World w;
+
+            std::vector<ecs::EntityHandle> entities;
+            auto start = BenchClock::now();
+            for (uint32_t mask = 0; mask < (1u << bits); mask++) {
+                auto e = w.newEntity();
+                addBenchTags(e, mask, std::make_integer_sequence<int, 17>{});
+                entities.push_back(e);
+            }
+            auto end = BenchClock::now();
+            const auto archetypes = w.am.archetypes.size();
+            MESSAGE(archetypes, " archetypes built in ", std::chrono::duration<double, std::milli>(end - start).count(), "ms");
+
+            /* Same number of entities sampled at every size, each in its own archetype */
+            std::vector<ecs::EntityHandle> sample;
+            const size_t stride = entities.size() / 1024;
+            for (size_t i = 0; i < entities.size(); i += stride) {
+                sample.push_back(entities[i]);
+            }
+
+            auto toggle = [&]() {
+                const auto s = BenchClock::now();
+                for (auto & e: sample) {
+                    e.add<BenchTag<20>>();
+                }
+                for (auto & e: sample) {
+                    e.remove<BenchTag<20>>();
+                }
+                const auto f = BenchClock::now();
+                return std::chrono::duration<double, std::nano>(f - s).count() / (2.0 * sample.size());
+            };
+
+            const auto first = toggle();
+            const auto steady = toggle();
+            MESSAGE(archetypes, " archetypes: first transition ", first, "ns, cached transition ", steady, "ns");
+        }
+    }
+
+    TEST_CASE("Updates only over static entities")
+    {
+        const uint32_t count = 1000000;
+        ecs::World w;
+        w.newEntity("Group:1").set<ecs::SystemGroup>({1, false, 0.f, 0.f});
+        auto ids = w.spawn<Transform>(count);
+        const auto touched = ids[count / 2];
+
+        uint32_t seen = 0;
+        w.createSystem("Reader").withQuery<Transform>()
+         .inGroup("Group:1")
+         .withUpdates()
+         .each<Transform>([&seen](ecs::EntityHandle, const Transform *)
+         {
+             seen++;
+         });
+        w.step(0.01f);
+
+        seen = 0;
+        auto start = BenchClock::now();
+        for (int frame = 0; frame < 100; frame++) {
+            w.step(0.01f);
+        }
+        auto end = BenchClock::now();
+        MESSAGE("withUpdates over ", count, " untouched: ", std::chrono::duration<double, std::micro>(end - start).count() / 100.0, "us per step (", seen, ")");
+
+        seen = 0;
+        start = BenchClock::now();
+        for (int frame = 0; frame < 100; frame++) {
+            w.set<Transform>(touched, Transform{});
+            w.step(0.01f);
+        }
+        end = BenchClock::now();
+        MESSAGE("withUpdates over ", count, " one write: ", std::chrono::duration<double, std::micro>(end - start).count() / 100.0, "us per step (", seen, ")");
+    }
+
+    TEST_CASE("Query system dispatch overhead")
+    {
+        ecs::World w;
+        w.newEntity("Group:1").set<ecs::SystemGroup>({1, false, 0.f, 0.f});
+        for (int i = 0; i < 16; i++) {
+            auto e = w.newEntity().set<Transform>({});
+            addBenchTags(e, static_cast<uint32_t>(i), std::make_integer_sequence<int, 4>{});
+        }
+
+        float sum = 0.f;
+        auto system = w.createSystem("Dispatch").withQuery<Transform>()
+                       .inGroup("Group:1")
+                       .each<Transform>([&sum](ecs::EntityHandle, const Transform * t)
+                       {
+                           sum += t->scale[0];
+                       });
+        w.executeSystem(system.id);
+
+        const uint32_t runs = 100000;
+        const auto start = BenchClock::now();
+        for (uint32_t i = 0; i < runs; i++) {
+            w.executeSystem(system.id);
+        }
+        const auto end = BenchClock::now();
+        MESSAGE("executeSystem over 16 tables: ", std::chrono::duration<double, std::nano>(end - start).count() / runs, "ns (", sum, ")");
+    }
+
+    TEST_CASE("Position plus velocity")
+    {
+        struct Position
+        {
+            float x, y, z;
+        };
+
+        struct Velocity
+        {
+            float x, y, z;
+        };
+
+        const uint32_t count = 1000000;
+        ecs::World w;
+        w.spawn<Position, Velocity>(count);
+        auto q = w.createQuery<Position, Velocity>().id;
+
+        std::vector<Position> positions(count);
+        std::vector<Velocity> velocities(count, Velocity{1.f, 2.f, 3.f});
+
+        auto start = BenchClock::now();
+        for (int round = 0; round < 10; round++) {
+            for (uint32_t i = 0; i < count; i++) {
+                positions[i].x += velocities[i].x;
+                positions[i].y += velocities[i].y;
+                positions[i].z += velocities[i].z;
+            }
+        }
+        auto end = BenchClock::now();
+        MESSAGE("hand written arrays: ", std::chrono::duration<double, std::nano>(end - start).count() / (10.0 * count), "ns per row (", positions[count / 2].x, ")");
+
+        start = BenchClock::now();
+        for (int round = 0; round < 10; round++) {
+            w.getResults(q).each<Position, const Velocity>([](ecs::EntityHandle, Position * p, const Velocity * v)
+            {
+                p->x += v->x;
+                p->y += v->y;
+                p->z += v->z;
+            });
+        }
+        end = BenchClock::now();
+        MESSAGE("QueryResult::each: ", std::chrono::duration<double, std::nano>(end - start).count() / (10.0 * count), "ns per row");
+
+        start = BenchClock::now();
+        for (int round = 0; round < 10; round++) {
+            w.getResults(q).eachChunk<Position, const Velocity>([](const ecs::Chunk<Position, const Velocity> & chunk)
+            {
+                auto p = chunk.get<Position>();
+                auto v = chunk.get<const Velocity>();
+                for (uint32_t i = 0; i < chunk.count; i++) {
+                    p[i].x += v[i].x;
+                    p[i].y += v[i].y;
+                    p[i].z += v[i].z;
+                }
+            });
+        }
+        end = BenchClock::now();
+        MESSAGE("QueryResult::eachChunk: ", std::chrono::duration<double, std::nano>(end - start).count() / (10.0 * count), "ns per row");
+    }
+}
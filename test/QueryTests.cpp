@@ -525,4 +525,47 @@ TEST_SUITE("Queries")
 
         world.deleteQuery(q1);
     }
+
+    TEST_CASE("Dense iteration across pages")
+    {
+        ecs::World world;
+
+        const uint32_t count = ecs::Column::pageRows * 2 + 10;
+        const auto spawned = world.spawn<TestComponent, TestComponent3>(count);
+        const std::vector<ecs::entity_t> ids(spawned.begin(), spawned.end());
+        world.newEntity().set<TestComponent>({0}).set<TestComponent3>({0}).add<TestTag>();
+
+        auto eq = world.createEntityQueue();
+        eq.triggerOnUpdate<TestComponent>();
+
+        auto q = world.createQuery<TestComponent, TestComponent3>().id;
+        {
+            uint32_t visited = 0;
+            auto r = world.getResults(q);
+            r.each<TestComponent, const TestComponent3>(
+                [&visited](ecs::EntityHandle, TestComponent * t, const TestComponent3 *)
+                {
+                    t->x = ++visited;
+                });
+            CHECK(visited == count + 1);
+            CHECK(r.getProcessed() == count + 1);
+        }
+        CHECK(world.get<TestComponent>(ids.back())->x != 0);
+        CHECK(world.getEntityQueue(eq.id)->entries.size() == count + 1);
+
+        /* A tag has no column, so every table takes the general path */
+        {
+            uint32_t tagged = 0;
+            auto r = world.getResults(q);
+            r.each<const TestComponent, const TestTag>(
+                [&tagged](ecs::EntityHandle, const TestComponent *, const TestTag * tag)
+                {
+                    if (tag) {
+                        tagged++;
+                    }
+                });
+            CHECK(tagged == 1);
+            CHECK(r.getProcessed() == count + 1);
+        }
+    }
 }
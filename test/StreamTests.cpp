@@ -4,6 +4,10 @@
 #include "RxECS.h"
 #include "TestComponents.h"
 
+#if !defined(_MSC_VER)
+#define _CrtCheckMemory() true
+#endif
+
 TEST_SUITE("Streams")
 {
     TEST_CASE("Basic")
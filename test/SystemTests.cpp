@@ -365,4 +365,225 @@ TEST_SUITE("Systems")
         world.step(0.0f);
         CHECK(c == 1);
     }
+
+    TEST_CASE("Changed and Added Terms")
+    {
+        ecs::World world;
+
+        world.newEntity("Group:1").set<ecs::SystemGroup>({1, false, 0.f, 0.f});
+
+        struct Writer { };
+
+        auto e1 = world.newEntity().set<TestComponent>({1});
+        auto e2 = world.newEntity().set<TestComponent>({2});
+        auto e3 = world.newEntity().set<TestComponent>({3}).set<TestComponent3>({3});
+
+        world.createSystem("Writer").withQuery<TestComponent, TestComponent3>()
+             .inGroup("Group:1")
+             .label<Writer>()
+             .each<TestComponent>([](ecs::EntityHandle, TestComponent * t)
+             {
+                 t->x++;
+             });
+
+        std::vector<ecs::entity_t> changed;
+        world.createSystem("Changed").withQuery<TestComponent>()
+             .changed<TestComponent>()
+             .inGroup("Group:1")
+             .after<Writer>()
+             .each<TestComponent>([&changed](ecs::EntityHandle e, const TestComponent *)
+             {
+                 changed.push_back(e.id);
+             });
+
+        std::vector<ecs::entity_t> added;
+        world.createSystem("Added").withQuery<TestComponent>()
+             .added<TestComponent>()
+             .inGroup("Group:1")
+             .after<Writer>()
+             .each<TestComponent>([&added](ecs::EntityHandle e, const TestComponent *)
+             {
+                 added.push_back(e.id);
+             });
+
+        world.step(0.01f);
+        CHECK(changed.size() == 3);
+        CHECK(added.size() == 3);
+
+        /* Only the writer's mutable parameter marks rows */
+        changed.clear();
+        added.clear();
+        world.step(0.01f);
+        CHECK(changed == std::vector<ecs::entity_t>{e3.id});
+        CHECK(added.empty());
+
+        /* set marks the row, a table move keeps the ticks */
+        changed.clear();
+        e1.set<TestComponent>({10});
+        e2.add<TestComponent2>();
+        auto e4 = world.newEntity().set<TestComponent>({4});
+        world.step(0.01f);
+        std::sort(changed.begin(), changed.end());
+        std::vector<ecs::entity_t> expected{e1.id, e3.id, e4.id};
+        std::sort(expected.begin(), expected.end());
+        CHECK(changed == expected);
+        CHECK(added == std::vector<ecs::entity_t>{e4.id});
+        CHECK(world.get<TestComponent>(e3.id)->x == 6);
+
+        /* update is a write too */
+        changed.clear();
+        e2.update<TestComponent>([](TestComponent * t) { t->x = 20; });
+        world.step(0.01f);
+        std::sort(changed.begin(), changed.end());
+        expected = {e2.id, e3.id};
+        std::sort(expected.begin(), expected.end());
+        CHECK(changed == expected);
+    }
+
+    TEST_CASE("Changed Ticks Are Only Stamped While Tracked")
+    {
+        ecs::World world;
+
+        world.newEntity("Group:1").set<ecs::SystemGroup>({1, false, 0.f, 0.f});
+
+        auto e = world.newEntity().set<TestComponent>({1});
+        world.createSystem("Writer").withQuery<TestComponent>()
+             .inGroup("Group:1")
+             .each<TestComponent>([](ecs::EntityHandle, TestComponent * t)
+             {
+                 t->x++;
+             });
+
+        const auto id = world.getComponentId<TestComponent>();
+        auto table = world.getTableForArchetype(world.getEntityArchetypeDetails(e).id);
+        const auto & ticks = table->getColumn(id)->getTicks(table->getEntityRow(e.id));
+        const auto addedTick = ticks.added;
+
+        /* Nothing reads changed ticks, so neither each nor set writes them */
+        CHECK(!world.tracksChanges(id));
+        world.step(0.01f);
+        e.set<TestComponent>({5});
+        CHECK(ticks.changed == addedTick);
+
+        auto q = world.createQuery<TestComponent>().changed<TestComponent>().id;
+        CHECK(world.tracksChanges(id));
+        world.step(0.01f);
+        CHECK(ticks.changed != addedTick);
+
+        world.deleteQuery(q);
+        CHECK(!world.tracksChanges(id));
+    }
+
+    TEST_CASE("Updates Only Skips Untouched Pages")
+    {
+        ecs::World world;
+
+        world.newEntity("Group:1").set<ecs::SystemGroup>({1, false, 0.f, 0.f});
+        world.newEntity("Group:2").set<ecs::SystemGroup>({2, false, 0.f, 0.f});
+
+        const uint32_t count = ecs::Column::pageRows * 3;
+        const auto spawned = world.spawn<TestComponent>(count);
+        const std::vector<ecs::entity_t> ids(spawned.begin(), spawned.end());
+
+        uint32_t seen = 0;
+        auto reader = world.createSystem("Reader").withQuery<TestComponent>()
+                           .inGroup("Group:1")
+                           .withUpdates()
+                           .each<TestComponent>([&seen](ecs::EntityHandle, const TestComponent *)
+                           {
+                               seen++;
+                           });
+
+        ecs::entity_t target = 0;
+        world.createSystem("Writer")
+             .inGroup("Group:2")
+             .execute([&target](ecs::World * w)
+             {
+                 if (target) {
+                     ecs::EntityHandle{target, w}.update<TestComponent>([](TestComponent * t) { t->x++; });
+                     target = 0;
+                 }
+             });
+
+        world.step(0.01f);
+        CHECK(seen == count);
+
+        seen = 0;
+        world.step(0.01f);
+        CHECK(seen == 0);
+        CHECK(world.get<ecs::System>(reader.id)->count == 0);
+
+        /* Only the page holding the write is walked */
+        target = ids[ecs::Column::pageRows * 2 + 5];
+        world.step(0.01f);
+        auto * table = world.getTableForArchetype(world.getEntityArchetypeDetails(ids[0]).id);
+        CHECK(table->pageUpdatedAfter(ecs::Column::pageRows * 2, 0));
+        CHECK(table->pageUpdateSequence[0] < table->pageUpdateSequence[2]);
+        seen = 0;
+        world.step(0.01f);
+        CHECK(seen == 1);
+
+        /* A row filling a hole left by a destroy takes its update into the new page */
+        target = ids[count - 1];
+        world.step(0.01f);
+        world.destroy(ids[0]);
+        seen = 0;
+        world.step(0.01f);
+        CHECK(seen == 1);
+    }
+
+    TEST_CASE("Chunk System")
+    {
+        ecs::World world;
+
+        world.newEntity("Group:1").set<ecs::SystemGroup>({1, false, 0.f, 0.f});
+
+        const uint32_t count = ecs::Column::pageRows * 2 + 3;
+        const auto spawned = world.spawn<TestComponent, TestComponent3>(count);
+        const std::vector<ecs::entity_t> ids(spawned.begin(), spawned.end());
+        for (uint32_t i = 0; i < count; i++) {
+            world.set<TestComponent3>(ids[i], {i});
+        }
+
+        uint32_t chunks = 0;
+        uint32_t rows = 0;
+        auto system = world.createSystem("Chunks").withQuery<TestComponent>()
+                           .changed<TestComponent>()
+                           .inGroup("Group:1")
+                           .eachChunk<TestComponent, const TestComponent3>(
+                               [&](const ecs::Chunk<TestComponent, const TestComponent3> & chunk)
+                               {
+                                   auto t = chunk.get<TestComponent>();
+                                   auto w = chunk.column<1>();
+                                   CHECK(t.size() == chunk.count);
+                                   CHECK(w.size() == chunk.count);
+                                   CHECK(chunk.entities.size() == chunk.count);
+                                   for (uint32_t i = 0; i < chunk.count; i++) {
+                                       CHECK(chunk.world->get<TestComponent3>(chunk.entities[i])->w == w[i].w);
+                                       t[i].x = w[i].w + 1;
+                                   }
+                                   chunks++;
+                                   rows += chunk.count;
+                               });
+
+        auto sp = world.get<ecs::System>(system.id);
+        CHECK(sp->writes.contains(world.getComponentId<TestComponent>()));
+        CHECK(sp->reads.contains(world.getComponentId<TestComponent3>()));
+
+        /* One chunk per page */
+        world.step(0.01f);
+        CHECK(chunks == 3);
+        CHECK(rows == count);
+        CHECK(world.get<TestComponent>(ids[count - 1])->x == count);
+
+        /* The system's own writes are not changes it sees, a set splits its page into runs */
+        chunks = 0;
+        rows = 0;
+        world.set<TestComponent>(ids[5], {0});
+        world.set<TestComponent>(ids[7], {0});
+        world.step(0.01f);
+        CHECK(chunks == 2);
+        CHECK(rows == 2);
+        CHECK(world.get<TestComponent>(ids[7])->x == 8);
+    }
 }
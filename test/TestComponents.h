@@ -72,4 +72,14 @@ struct TestTag
 struct TestRelation: ecs::Relation
 {
     
-};
\ No newline at end of file
+};
+
+struct alignas(16) WideComponent
+{
+    float v[4];
+};
+
+template<>
+struct ecs::ColumnAlignment<WideComponent> : std::integral_constant<uint16_t, 128>
+{
+};
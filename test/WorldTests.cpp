@@ -23,12 +23,68 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <random>
 
 #include "doctest.h"
 #include "RxECS.h"
 #include "TestComponents.h"
 
+/* Counts constructions to check set/emplace never build over a live row */
+struct Counted
+{
+    static inline int live = 0;
+    static inline int defaults = 0;
+    static inline int copies = 0;
+    static inline int assigns = 0;
+
+    std::string value;
+
+    Counted()
+    {
+        live++;
+        defaults++;
+    }
+
+    explicit Counted(std::string v)
+        : value(std::move(v))
+    {
+        live++;
+    }
+
+    Counted(const Counted & other)
+        : value(other.value)
+    {
+        live++;
+        copies++;
+    }
+
+    Counted(Counted && other) noexcept
+        : value(std::move(other.value))
+    {
+        live++;
+    }
+
+    Counted & operator=(const Counted & other)
+    {
+        value = other.value;
+        assigns++;
+        return *this;
+    }
+
+    Counted & operator=(Counted && other) noexcept
+    {
+        value = std::move(other.value);
+        assigns++;
+        return *this;
+    }
+
+    ~Counted()
+    {
+        live--;
+    }
+};
+
 TEST_SUITE("World")
 {
     TEST_CASE("Entity basics")
@@ -175,6 +231,24 @@ TEST_SUITE("World")
         }
     }
 
+    TEST_CASE("Component traits")
+    {
+        ecs::World w;
+
+        auto trivial = w.getComponentDetails(w.getComponentId<TestComponent>());
+        CHECK(trivial->triviallyCopyable);
+        CHECK(trivial->triviallyDestructible);
+        CHECK(trivial->triviallyConstructible);
+
+        auto complex = w.getComponentDetails(w.getComponentId<TestComponent2>());
+        CHECK(!complex->triviallyCopyable);
+        CHECK(!complex->triviallyDestructible);
+        CHECK(complex->functions == &ecs::componentFunctions<TestComponent2>);
+
+        auto e = w.newEntity().add<TestComponent>();
+        CHECK(e.get<TestComponent>()->x == 0);
+    }
+
     TEST_CASE("Missing component should return nullptr")
     {
         ecs::World w;
@@ -230,6 +304,81 @@ TEST_SUITE("World")
 
         CHECK(e.has<TestTag>());
         CHECK(e.has<TestComponent>());
+
+        SUBCASE("Tags have no column") {
+            auto tag = w.getComponentId<TestTag>();
+            CHECK(w.getComponentDetails(tag)->isTag);
+            CHECK(!w.getComponentDetails(w.getComponentId<TestComponent>())->isTag);
+
+            auto table = w.getTableForArchetype(w.getEntityArchetypeDetails(e).id);
+            CHECK(table->hasComponent(tag));
+            CHECK(table->getColumn(tag) == nullptr);
+            CHECK(table->columns.size() == 1);
+            CHECK(table->getColumn(w.getComponentId<TestComponent>()) == table->columns[0].get());
+            CHECK(w.getComponentIndex(tag) != ecs::World::invalidComponentIndex);
+            CHECK(e.get<TestTag>() != nullptr);
+        }
+
+        SUBCASE("Moves keep component data") {
+            e.set<TestComponent>({5});
+            e.remove<TestTag>();
+            CHECK(!e.has<TestTag>());
+            CHECK(e.get<TestTag>() == nullptr);
+            CHECK(e.get<TestComponent>()->x == 5);
+
+            e.add<TestTag>();
+            CHECK(e.get<TestComponent>()->x == 5);
+        }
+
+        SUBCASE("Queries match tags") {
+            w.newEntity().add<TestComponent>();
+            auto q = w.createQuery<TestTag>();
+            auto res = w.getResults(q.id);
+            CHECK(res.count() == 1);
+            uint32_t c = 0;
+            res.each<TestTag, TestComponent>(
+                [&](ecs::EntityHandle, const TestTag * t, const TestComponent * tc) {
+                    CHECK(t != nullptr);
+                    CHECK(tc != nullptr);
+                    c++;
+                }
+            );
+            CHECK(c == 1);
+        }
+
+        SUBCASE("Dynamic components are tags") {
+            auto parent = w.newEntity();
+            parent.setAsParent();
+            CHECK(w.getComponentDetails(parent.id)->isTag);
+            e.addParent(parent);
+            CHECK(e.hasParent(parent));
+            auto table = w.getTableForArchetype(w.getEntityArchetypeDetails(e).id);
+            CHECK(table->getColumn(parent.id) == nullptr);
+        }
+
+        SUBCASE("High component indices are found without a slot") {
+            auto parent = w.newEntity();
+            parent.setAsParent();
+            while (w.getComponentIndex(parent.id) < ecs::Table::maxSlottedIndex) {
+                parent = w.newEntity();
+                parent.setAsParent();
+            }
+            e.addParent(parent).add<TestComponent2>();
+            auto id2 = w.getComponentId<TestComponent2>();
+            CHECK(w.getComponentIndex(id2) > ecs::Table::maxSlottedIndex);
+
+            auto table = w.getTableForArchetype(w.getEntityArchetypeDetails(e).id);
+            CHECK(table->columnSlots.size() <= ecs::Table::maxSlottedIndex);
+            REQUIRE(table->getColumn(id2) != nullptr);
+            CHECK(table->getColumn(id2)->componentId == id2);
+            CHECK(table->getColumn(w.getComponentId<TestComponent>())->componentId == w.getComponentId<TestComponent>());
+            CHECK(table->getColumn(parent.id) == nullptr);
+            CHECK(w.getComponentIndex(w.getComponentId<TestComponent3>()) > ecs::Table::maxSlottedIndex);
+            CHECK(table->getColumn(w.getComponentId<TestComponent3>()) == nullptr);
+
+            e.set<TestComponent2>({7});
+            CHECK(e.get<TestComponent2>()->y == 7);
+        }
     }
 
     TEST_CASE("Singleton support")
@@ -330,6 +479,49 @@ TEST_SUITE("World")
             CHECK(j.get<Bloat>()->a == 11);
             CHECK(j.get<BloatWith>()->entity == prefabBoss.id);
         }
+        SUBCASE("Instantiate many") {
+            struct BloatLabel
+            {
+                std::string label;
+            };
+            prefab.set<BloatLabel>({std::string(40, 'x')});
+            world.set<ecs::Name>(prefab.id, {std::string{"many"}});
+
+            auto eq = world.createEntityQueue();
+            eq.triggerOnAdd<Bloat>();
+
+            const uint32_t count = 2500;
+            auto span = world.instantiate(prefab.id, count);
+            std::vector<ecs::entity_t> instances(span.begin(), span.end());
+            CHECK(instances.size() == count);
+
+            for (auto id: instances) {
+                auto i = ecs::EntityHandle{id, &world};
+                CHECK(i.isAlive());
+                CHECK(!i.has<ecs::Prefab>());
+                CHECK(!i.has<ecs::Name>());
+                CHECK(i.get<Bloat>()->a == 11);
+                CHECK(i.get<BloatWith>()->entity == prefabBoss.id);
+                CHECK(i.get<BloatLabel>()->label == std::string(40, 'x'));
+            }
+            CHECK(prefab.get<BloatLabel>()->label == std::string(40, 'x'));
+
+            auto q = world.createQuery<Bloat>().id;
+            CHECK(world.getResults(q).count() == count);
+
+            uint32_t adds = 0;
+            eq.each(
+                [&](ecs::EntityHandle) {
+                    adds++;
+                    return true;
+                }
+            );
+            CHECK(adds == count);
+
+            world.destroy(instances.front());
+            CHECK(world.getResults(q).count() == count - 1);
+            CHECK(world.get<BloatLabel>(instances.back())->label == std::string(40, 'x'));
+        }
         SUBCASE("Prefabs not in Query 1") {
             auto q = world.createQuery<Bloat>().id;
 
@@ -372,6 +564,51 @@ TEST_SUITE("World")
             CHECK(!e.has<TestComponent>());
         }
 
+        SUBCASE("Whole tables") {
+            auto ids = w.spawn<TestComponent, TestComponent2>(1500);
+            std::vector<ecs::entity_t> batch(ids.begin(), ids.end());
+            for (uint32_t i = 0; i < batch.size(); i++) {
+                w.set<TestComponent2>(batch[i], {.y = i, .z = std::to_string(i)});
+            }
+            auto spawned = w.spawn<TestComponent3>(10);
+            std::vector<ecs::entity_t> partial(spawned.begin(), spawned.end());
+            std::vector<ecs::entity_t> some(partial.begin(), partial.begin() + 5);
+
+            auto from = w.getTableForArchetype(w.getEntityArchetypeDetails(batch[0]).id);
+            auto * column = from->getColumn(w.getComponentId<TestComponent2>());
+
+            for (auto id: batch) {
+                w.addDeferred<TestTag>(id);
+            }
+            w.addDeferred<TestTag>(batch[3]);
+            for (auto id: some) {
+                w.addDeferred<TestTag>(id);
+            }
+            w.executeDeferred();
+
+            /* The whole table was relabelled, its column buffers moved with it */
+            auto to = w.getTableForArchetype(w.getEntityArchetypeDetails(batch[0]).id);
+            CHECK(to != from);
+            CHECK(from->entities.empty());
+            CHECK(to->getColumn(w.getComponentId<TestComponent2>()) == column);
+            for (uint32_t i = 0; i < batch.size(); i++) {
+                CHECK(w.has<TestTag>(batch[i]));
+                CHECK(to->entities[i] == batch[i]);
+                CHECK(w.get<TestComponent2>(batch[i])->z == std::to_string(i));
+            }
+            for (uint32_t i = 0; i < partial.size(); i++) {
+                CHECK(w.has<TestTag>(partial[i]) == (i < 5));
+            }
+
+            for (auto id: batch) {
+                w.removeDeferred<TestTag>(id);
+            }
+            w.executeDeferred();
+            CHECK(from->entities.size() == batch.size());
+            CHECK(from->getColumn(w.getComponentId<TestComponent2>()) == column);
+            CHECK(w.get<TestComponent2>(batch[1499])->y == 1499);
+        }
+
         SUBCASE("Destroy") {
             e.destroyDeferred();
             CHECK(e.isAlive());
@@ -479,6 +716,84 @@ TEST_SUITE("World")
         CHECK(e.description() == "Fred");
     }
 
+    TEST_CASE("Entity store pages")
+    {
+        ecs::EntityStore store;
+
+        const auto first = store.add();
+        const auto lastInPage = first + ecs::EntityStore::pageSize - 1;
+        while (store.size() <= lastInPage) {
+            store.add();
+        }
+        auto * firstEntry = &store[first];
+        auto * lastEntry = &store[lastInPage];
+        auto * firstSequence = &store.updateSequence(first);
+        store[first] = {3, 7, 11, true};
+        store.updateSequence(first) = 42;
+        store.updateSequence(lastInPage) = 43;
+
+        /* Growing across page boundaries leaves existing records where they are */
+        while (store.size() < ecs::EntityStore::pageSize * 3 + 5) {
+            const auto i = store.add();
+            CHECK(!store[i].alive);
+            CHECK(store.updateSequence(i) == 0);
+        }
+        CHECK(&store[first] == firstEntry);
+        CHECK(&store[lastInPage] == lastEntry);
+        CHECK(&store.updateSequence(first) == firstSequence);
+        CHECK(store[first].version == 3);
+        CHECK(store[first].row == 7);
+        CHECK(store.updateSequence(first) == 42);
+        CHECK(store.updateSequence(lastInPage) == 43);
+    }
+
+    TEST_CASE("Entity update sequences survive recycling")
+    {
+        ecs::World w;
+        w.newEntity("Group:1").set<ecs::SystemGroup>({1, false, 0.f, 0.f});
+
+        /* Enough entities that the store spans several pages */
+        const auto spawned = w.spawn<TestComponent>(ecs::EntityStore::pageSize * 2 + 10);
+        const std::vector<ecs::entity_t> ids(spawned.begin(), spawned.end());
+
+        std::vector<ecs::entity_t> seen;
+        w.createSystem("Reader").withQuery<TestComponent>()
+         .inGroup("Group:1")
+         .withUpdates()
+         .each<TestComponent>([&seen](ecs::EntityHandle e, const TestComponent *)
+         {
+             seen.push_back(e.id);
+         });
+        w.step(0.01f);
+
+        /* An update made before other slots are destroyed and reused is still seen, the reused
+         * slots only report their new occupant */
+        const auto kept = ids[ecs::EntityStore::pageSize + 3];
+        w.set<TestComponent>(kept, {1});
+        w.destroy(ids[2]);
+        w.destroy(ids[ecs::EntityStore::pageSize * 2]);
+        auto reused = w.newEntity().set<TestComponent>({2});
+        auto reused2 = w.newEntity();
+        CHECK(ecs::index(reused.id) == ecs::index(ids[ecs::EntityStore::pageSize * 2]));
+        CHECK(ecs::index(reused2.id) == ecs::index(ids[2]));
+
+        seen.clear();
+        w.step(0.01f);
+        std::sort(seen.begin(), seen.end());
+        std::vector<ecs::entity_t> expected{kept, reused.id};
+        std::sort(expected.begin(), expected.end());
+        CHECK(seen == expected);
+
+        /* A slot recycled into an entity with no writes yet starts clean */
+        reused2.add<TestComponent>();
+        seen.clear();
+        w.step(0.01f);
+        CHECK(seen == std::vector<ecs::entity_t>{reused2.id});
+        seen.clear();
+        w.step(0.01f);
+        CHECK(seen.empty());
+    }
+
     TEST_CASE("Entity operator bool")
     {
         ecs::World w;
@@ -640,6 +955,535 @@ TEST_SUITE("World")
         CHECK(table0->description() == "Empty");
     }
 
+    TEST_CASE("Column pages keep rows in place")
+    {
+        ecs::World w;
+
+        std::vector<ecs::entity_t> ids;
+        for (uint32_t i = 0; i < ecs::Column::pageRows; i++) {
+            ids.push_back(w.newEntity().set<TestComponent>({i}).id);
+        }
+
+        const TestComponent * first = w.get<TestComponent>(ids[0]);
+        const TestComponent * last = w.get<TestComponent>(ids.back());
+
+        for (uint32_t i = 0; i < ecs::Column::pageRows * 3; i++) {
+            w.newEntity().set<TestComponent>({i});
+        }
+
+        CHECK(w.get<TestComponent>(ids[0]) == first);
+        CHECK(w.get<TestComponent>(ids.back()) == last);
+        CHECK(first->x == 0);
+        CHECK(last->x == ecs::Column::pageRows - 1);
+
+        auto q = w.createQuery<TestComponent>().id;
+        auto res = w.getResults(q);
+        CHECK(res.count() == ecs::Column::pageRows * 4);
+        CHECK(res.size() == 4);
+        for (auto & tv: res) {
+            auto span = tv.getColumn<TestComponent>();
+            CHECK(span.size() == tv.count);
+        }
+    }
+
+    TEST_CASE("Column ticks are paged and wrap")
+    {
+        ecs::World w;
+
+        auto e = w.newEntity().set<TestComponent>({1});
+        auto table = w.getTableForArchetype(w.getEntityArchetypeDetails(e).id);
+        auto column = table->getColumn(w.getComponentId<TestComponent>());
+        for (uint32_t i = 0; i < ecs::Column::pageRows; i++) {
+            w.newEntity().set<TestComponent>({i});
+        }
+
+        /* Tick pages follow the row pages, so growing doesn't move a full page's ticks */
+        CHECK(column->tickPages.size() == column->pages.size());
+        auto * ticks = &column->getTicks(ecs::Column::pageRows);
+        column->markChanged(ecs::Column::pageRows, 1, 42);
+        for (uint32_t i = 0; i < ecs::Column::pageRows * 2; i++) {
+            w.newEntity().set<TestComponent>({i});
+        }
+        CHECK(&column->getTicks(ecs::Column::pageRows) == ticks);
+        CHECK(ticks->changed == 42);
+        CHECK(column->getTicks(0).added == w.getChangeTick());
+
+        /* Comparisons are relative to now, so they hold across the wrap */
+        const ecs::tick_t top = ~ecs::tick_t{0};
+        CHECK(ecs::Column::tickNewer(5, top - 5, 10));
+        CHECK(!ecs::Column::tickNewer(top - 10, top - 5, 10));
+        CHECK(ecs::Column::tickNewer(top - 1, top - 5, 10));
+
+        /* Ticks from before maxTickAge are pulled up to it, and so never read as newer */
+        const ecs::tick_t now = 100;
+        column->getTicks(0).changed = now + 1;
+        column->getTicks(1).changed = now - 1;
+        column->clampTicks(now);
+        CHECK(column->getTicks(0).changed == now - ecs::Column::maxTickAge);
+        CHECK(column->getTicks(1).changed == now - 1);
+        CHECK(!ecs::Column::tickNewer(column->getTicks(0).changed, now - ecs::Column::maxTickAge, now));
+    }
+
+    TEST_CASE("Column alignment")
+    {
+        ecs::World w;
+
+        CHECK(w.getColumnAlignment<TestComponent>() == ecs::defaultColumnAlignment);
+        CHECK(w.getColumnAlignment<WideComponent>() == 128);
+
+        for (uint32_t i = 0; i < ecs::Column::pageRows + 10; i++) {
+            w.newEntity().add<TestComponent>().add<WideComponent>();
+        }
+
+        auto f = w.createFilter(w.makeComponentList<TestComponent, WideComponent>());
+        for (auto tv: f) {
+            auto narrow = tv.getColumn<TestComponent>();
+            auto wide = tv.getColumn<WideComponent>();
+            CHECK(reinterpret_cast<uintptr_t>(narrow.data()) % ecs::defaultColumnAlignment == 0);
+            CHECK(reinterpret_cast<uintptr_t>(wide.data()) % 128 == 0);
+        }
+    }
+
+    TEST_CASE("World allocator")
+    {
+        struct CountingAllocator : ecs::WorldAllocator
+        {
+            ecs::PoolAllocator pool;
+            int64_t live = 0;
+            uint32_t calls = 0;
+
+            void * allocate(size_t size, size_t alignment) override
+            {
+                live += static_cast<int64_t>(size);
+                calls++;
+                return pool.allocate(size, alignment);
+            }
+
+            void deallocate(void * ptr, size_t size, size_t alignment) override
+            {
+                live -= static_cast<int64_t>(size);
+                pool.deallocate(ptr, size, alignment);
+            }
+        };
+
+        CountingAllocator counter;
+        {
+            ecs::World w(&counter);
+            CHECK(w.getAllocator() == &counter);
+
+            auto callsBefore = counter.calls;
+            for (uint32_t i = 0; i < 100; i++) {
+                w.newEntity().set<TestComponent>({i}).set<TestComponent2>({i, "x"});
+            }
+            CHECK(counter.calls > callsBefore);
+
+            callsBefore = counter.calls;
+            w.setSingleton<TestComponent3>({3});
+            CHECK(counter.calls > callsBefore);
+
+            callsBefore = counter.calls;
+            auto e = w.newEntity();
+            e.setDeferred<TestComponent3>({4});
+            CHECK(counter.calls > callsBefore);
+            w.executeDeferred();
+            CHECK(e.get<TestComponent3>()->w == 4);
+        }
+        CHECK(counter.live == 0);
+        CHECK(counter.pool.slabBytes() > 0);
+    }
+
+    TEST_CASE("Pool allocator reuses blocks")
+    {
+        ecs::PoolAllocator pool;
+
+        void * a = pool.allocate(100, 16);
+        CHECK(reinterpret_cast<uintptr_t>(a) % 16 == 0);
+        pool.deallocate(a, 100, 16);
+        void * b = pool.allocate(128, 64);
+        CHECK(a == b);
+        CHECK(reinterpret_cast<uintptr_t>(b) % 64 == 0);
+        pool.deallocate(b, 128, 64);
+
+        void * big = pool.allocate(ecs::PoolAllocator::maxBlockSize * 2, 64);
+        CHECK(big != nullptr);
+        pool.deallocate(big, ecs::PoolAllocator::maxBlockSize * 2, 64);
+    }
+
+    TEST_CASE("Multiple components in one move")
+    {
+        ecs::World w;
+
+        auto e = w.newEntity();
+        const auto from = w.getEntityArchetypeDetails(e).id;
+
+        auto eq = w.createEntityQueue();
+        eq.triggerOnAdd<TestComponent2>();
+
+        SUBCASE("Add") {
+            e.add<TestComponent, TestComponent2, TestTag>();
+            CHECK(e.has<TestComponent>());
+            CHECK(e.has<TestComponent2>());
+            CHECK(e.has<TestTag>());
+
+            /* Only the final archetype has a table */
+            auto & ad = w.getEntityArchetypeDetails(e);
+            CHECK(ad.components.size() == 3);
+            for (auto & at: w) {
+                if (at.id != ad.id && at.id != from && at.components.size() < 3 && !at.components.empty()) {
+                    bool intermediate = std::ranges::includes(ad.components, at.components);
+                    CHECK((!intermediate || w.getTableForArchetype(at.id) == nullptr));
+                }
+            }
+
+            e.add<TestComponent, TestComponent3>();
+            CHECK(e.has<TestComponent3>());
+            CHECK(e.get<TestComponent>()->x == 0);
+
+            int adds = 0;
+            eq.each(
+                [&](ecs::EntityHandle h) {
+                    CHECK(h == e);
+                    adds++;
+                    return true;
+                }
+            );
+            CHECK(adds == 1);
+        }
+
+        SUBCASE("Repeated ids") {
+            const auto c2 = w.getComponentId<TestComponent2>();
+            const std::array<ecs::component_id_t, 3> ids{c2, w.getComponentId<TestComponent>(), c2};
+            w.add(e.id, ids);
+            CHECK(e.has<TestComponent>());
+            CHECK(e.has<TestComponent2>());
+
+            int adds = 0;
+            eq.each(
+                [&](ecs::EntityHandle) {
+                    adds++;
+                    return true;
+                }
+            );
+            CHECK(adds == 1);
+        }
+
+        SUBCASE("Set") {
+            e.set(TestComponent{7}, TestComponent2{.y = 3, .z = "abc"}, ecs::Name{"Multi"});
+            CHECK(e.get<TestComponent>()->x == 7);
+            CHECK(e.get<TestComponent2>()->z == "abc");
+            CHECK(w.lookup("Multi") == e);
+
+            e.set(TestComponent{8}, TestComponent3{.w = 2});
+            CHECK(e.get<TestComponent>()->x == 8);
+            CHECK(e.get<TestComponent3>()->w == 2);
+            CHECK(e.get<TestComponent2>()->y == 3);
+        }
+    }
+
+    TEST_CASE("Spawn")
+    {
+        ecs::World w;
+
+        auto e = w.newEntity().add<TestComponent>();
+        auto ids = w.spawn<TestComponent, TestComponent2, TestTag>(3000);
+        CHECK(ids.size() == 3000);
+
+        std::vector<ecs::entity_t> spawned(ids.begin(), ids.end());
+        for (auto id: spawned) {
+            CHECK(w.isAlive(id));
+            CHECK(w.has<TestTag>(id));
+            CHECK(w.get<TestComponent>(id)->x == 0);
+            CHECK(w.get<TestComponent2>(id)->z.empty());
+        }
+
+        auto table = w.getTableForArchetype(w.getEntityArchetypeDetails(spawned[0]).id);
+        CHECK(table->entities.size() == 3000);
+        for (uint32_t row = 0; row < table->entities.size(); row++) {
+            CHECK(table->entities[row] == spawned[row]);
+        }
+        for (auto & column: table->columns) {
+            CHECK(column->count == 3000);
+            CHECK(column->pageCount() == 3);
+        }
+
+        /* Spawned rows behave like any other */
+        w.set<TestComponent2>(spawned[5], {.y = 1, .z = "spawned"});
+        w.destroy(spawned[0]);
+        CHECK(w.get<TestComponent2>(spawned[5])->z == "spawned");
+        CHECK(e.has<TestComponent>());
+
+        const std::array<ecs::component_id_t, 1> list = {w.getComponentId<TestComponent3>()};
+        auto more = w.spawn(list, 10);
+        CHECK(more.size() == 10);
+        CHECK(w.has<TestComponent3>(more[9]));
+        CHECK(w.isAlive(spawned[0]) == false);
+    }
+
+    TEST_CASE("Bulk changes over a query")
+    {
+        ecs::World w;
+
+        auto ids = w.spawn<TestComponent, TestComponent2>(2500);
+        std::vector<ecs::entity_t> bulk(ids.begin(), ids.end());
+        for (uint32_t i = 0; i < bulk.size(); i++) {
+            w.set<TestComponent2>(bulk[i], {.y = i, .z = std::to_string(i)});
+        }
+        auto named = w.newEntity("bulk named");
+        named.set<TestComponent2>({.y = 7, .z = "named"});
+        auto other = w.newEntity().add<TestComponent3>();
+
+        auto q = w.createQuery<TestComponent2>().id;
+        auto eq = w.createEntityQueue();
+        eq.triggerOnAdd<TestTag>();
+
+        SUBCASE("Add and remove") {
+            w.addToAll<TestTag>(q);
+            CHECK(named.has<TestTag>());
+            CHECK(!other.has<TestTag>());
+            for (uint32_t i = 0; i < bulk.size(); i++) {
+                CHECK(w.has<TestTag>(bulk[i]));
+                CHECK(w.get<TestComponent2>(bulk[i])->z == std::to_string(i));
+            }
+            uint32_t adds = 0;
+            eq.each(
+                [&](ecs::EntityHandle) {
+                    adds++;
+                    return true;
+                }
+            );
+            CHECK(adds == bulk.size() + 1);
+
+            w.removeFromAll<TestComponent>(q);
+            CHECK(!w.has<TestComponent>(bulk[100]));
+            CHECK(w.get<TestComponent2>(bulk[100])->y == 100);
+            CHECK(w.getResults(q).count() == bulk.size() + 1);
+
+            w.removeFromAll<ecs::Name>(q);
+            CHECK(!named.has<ecs::Name>());
+            CHECK(!w.lookup("bulk named").isAlive());
+        }
+
+        SUBCASE("Destroy") {
+            w.destroyAll(q);
+            CHECK(w.getResults(q).count() == 0);
+            CHECK(!named.isAlive());
+            CHECK(!w.lookup("bulk named").isAlive());
+            for (auto id: bulk) {
+                CHECK(!w.isAlive(id));
+            }
+            CHECK(other.isAlive());
+
+            /* Released slots are reused */
+            auto e = w.newEntity();
+            CHECK(ecs::index(e.id) <= ecs::index(named.id));
+        }
+    }
+
+    TEST_CASE("Component ids across worlds")
+    {
+        struct SlotA
+        {
+            uint32_t a;
+        };
+        struct SlotB
+        {
+            uint32_t b;
+        };
+        using Registered = ecs::ComponentList<SlotB, SlotA>;
+
+        auto w1 = std::make_unique<ecs::World>();
+        w1->registerComponents<SlotA, SlotB>();
+        const auto a1 = w1->getComponentId<SlotA>();
+        const auto b1 = w1->getComponentId<SlotB>();
+        CHECK(ecs::index(a1) < ecs::index(b1));
+
+        {
+            ecs::World w2;
+            w2.newEntity();
+            w2.registerComponents(Registered{});
+            CHECK(ecs::index(w2.getComponentId<SlotB>()) < ecs::index(w2.getComponentId<SlotA>()));
+            CHECK(w2.getComponentId<SlotA>() != a1);
+
+            /* Alternating between worlds always resolves against the right one */
+            CHECK(w1->getComponentId<SlotA>() == a1);
+            CHECK(w2.getComponentDetails(w2.getComponentId<SlotA>())->size == sizeof(SlotA));
+            CHECK(w1->getComponentId<SlotB>() == b1);
+        }
+
+        /* A world built where the last one lived gets its own ids, not stale cached ones */
+        w1.reset();
+        ecs::World w3;
+        auto e = w3.newEntity().set<SlotB>({.b = 3});
+        CHECK(w3.has<SlotB>(e.id));
+        CHECK(w3.getComponentDetails(w3.getComponentId<SlotB>())->name.find("SlotB") != std::string::npos);
+    }
+
+    TEST_CASE("Component registry")
+    {
+        ecs::World w;
+
+        const auto c = w.getComponentId<TestComponent2>();
+        auto details = w.getComponentDetails(c);
+        CHECK(details->size == sizeof(TestComponent2));
+        CHECK(details->name == w.get<ecs::Component>(c)->name);
+
+        /* Trigger lists are written through to the component entity */
+        auto eq = w.createEntityQueue();
+        eq.triggerOnAdd<TestComponent2>();
+        CHECK(w.getComponentDetails(c)->onAdds.size() == 1);
+        CHECK(w.get<ecs::Component>(c)->onAdds == w.getComponentDetails(c)->onAdds);
+
+        auto e = w.newEntity();
+        auto parent = w.newEntity();
+        e.set<TestComponent2>({.y = 1});
+        w.setAsParent(parent.id);
+        w.add(e.id, parent.id);
+        CHECK(w.getComponentDetails(parent.id)->isTag);
+
+        int adds = 0;
+        eq.each(
+            [&](ecs::EntityHandle h) {
+                CHECK(h == e);
+                adds++;
+                return true;
+            }
+        );
+        CHECK(adds == 1);
+
+        w.removeAddTrigger(c, eq.id);
+        CHECK(w.getComponentDetails(c)->onAdds.empty());
+        CHECK(w.get<ecs::Component>(c)->onAdds.empty());
+    }
+
+    TEST_CASE("Set and emplace build components in place")
+    {
+        {
+            ecs::World w;
+            auto e = w.newEntity();
+
+            e.emplace<Counted>(std::string(64, 'a'));
+            CHECK(e.get<Counted>()->value == std::string(64, 'a'));
+            CHECK(Counted::defaults == 0);
+            CHECK(Counted::copies == 0);
+
+            /* Existing components are assigned over, never constructed on top of */
+            const Counted lvalue{std::string(64, 'b')};
+            e.set(lvalue);
+            CHECK(e.get<Counted>()->value == std::string(64, 'b'));
+            CHECK(Counted::assigns == 1);
+            e.set(Counted{std::string(64, 'c')});
+            CHECK(Counted::assigns == 2);
+            CHECK(e.get<Counted>()->value == std::string(64, 'c'));
+
+            /* A missing component is copy constructed straight from the value */
+            auto f = w.newEntity();
+            f.set(lvalue);
+            CHECK(f.get<Counted>()->value == std::string(64, 'b'));
+            CHECK(Counted::copies == 1);
+            f.set(Counted{"moved"});
+            CHECK(f.get<Counted>()->value == "moved");
+
+            auto g = w.newEntity();
+            g.set(Counted{"deferred"});
+            g.setDeferred(Counted{"replaced"});
+            w.executeDeferred();
+            CHECK(g.get<Counted>()->value == "replaced");
+
+            e.emplace<TestTag>();
+            CHECK(e.has<TestTag>());
+            e.set<ecs::Name>({"in place"});
+            CHECK(w.lookup("in place") == e);
+
+            /* A deferred set moves its value in, the index must see the stored name */
+            g.setDeferred(ecs::Name{"deferred name"});
+            w.executeDeferred();
+            CHECK(w.lookup("deferred name") == g);
+            CHECK(g.get<ecs::Name>()->name == "deferred name");
+
+            CHECK(Counted::defaults == 0);
+        }
+        CHECK(Counted::live == 0);
+    }
+
+    TEST_CASE("Archetype signatures")
+    {
+        ecs::World w;
+
+        auto e = w.newEntity().add<TestComponent>().add<TestTag>();
+        auto & ad = w.getEntityArchetypeDetails(e);
+        for (auto c: ad.components) {
+            CHECK(ad.signature.test(w.getComponentIndex(c)));
+        }
+        CHECK(!w.has<TestComponent2>(e));
+        CHECK(!w.has(e, e.id));
+
+        ecs::ComponentSignature a, b;
+        a.set(3);
+        a.set(130);
+        b.set(130);
+        CHECK(a.containsAll(b));
+        CHECK(!b.containsAll(a));
+        CHECK(a.intersects(b));
+        b.set(200);
+        CHECK(!a.containsAll(b));
+        CHECK(!a.intersects(ecs::ComponentSignature{}));
+    }
+
+    TEST_CASE("Archetype edges")
+    {
+        ecs::World w;
+
+        auto e = w.newEntity().add<TestComponent>();
+        const auto from = w.getEntityArchetypeDetails(e).id;
+        e.add<TestTag>();
+        const auto to = w.getEntityArchetypeDetails(e).id;
+        const auto tag = w.getComponentId<TestTag>();
+
+        CHECK(w.am.archetypes[from].edges.at(tag).add == to);
+        CHECK(w.am.archetypes[to].edges.at(tag).remove == from);
+
+        const auto archetypes = w.am.archetypes.size();
+        for (int i = 0; i < 10; i++) {
+            e.remove<TestTag>();
+            CHECK(w.getEntityArchetypeDetails(e).id == from);
+            e.add<TestTag>();
+            CHECK(w.getEntityArchetypeDetails(e).id == to);
+        }
+        CHECK(w.am.archetypes.size() == archetypes);
+    }
+
+    TEST_CASE("Archetype hash collisions")
+    {
+        ecs::World w;
+
+        auto c1 = w.getComponentId<TestComponent>();
+        auto c2 = w.getComponentId<TestComponent2>();
+
+        const auto a = w.am.findOrCreateArchetype({c1});
+
+        /* Pretend {c2} hashes the same as {c1} */
+        ecs::Archetype probe;
+        probe.components = {c2};
+        probe.generateHash();
+        w.am.archetypeMap.insert_or_assign(probe.hash_value, a);
+
+        const auto b = w.am.findOrCreateArchetype({c2});
+        CHECK(b != a);
+        CHECK(w.am.archetypes[b].components == std::set<ecs::component_id_t>{c2});
+        CHECK(w.am.findOrCreateArchetype({c2}) == b);
+
+        CHECK(w.am.findOrCreateArchetype({c1}) == a);
+        CHECK(w.am.archetypes[b].nextWithHash == a);
+
+        /* Unlinking b leaves a at the head of the collided chain */
+        w.am.forgetArchetype(b);
+        CHECK(w.am.archetypeMap.at(probe.hash_value) == a);
+        const auto b2 = w.am.findOrCreateArchetype({c2});
+        CHECK(b2 != a);
+        CHECK(b2 != b);
+        CHECK(w.am.findOrCreateArchetype({c1}) == a);
+    }
+
     TEST_CASE("Dynamic Components")
     {
         ecs::World w;
@@ -669,7 +1513,7 @@ TEST_SUITE("World")
             }
         );
 
-        auto ad = w.getEntityArchetypeDetails(e);
+        auto & ad = w.getEntityArchetypeDetails(e);
         auto tab = w.getTableForArchetype(ad.id);
         (void) tab;
         e.removeParent(dc);